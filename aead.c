@@ -0,0 +1,171 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include "aead.h"
+
+static void put_be32(unsigned char *p, uint value)
+{
+    p[0] = (value >> 24) & 0xFF;
+    p[1] = (value >> 16) & 0xFF;
+    p[2] = (value >> 8) & 0xFF;
+    p[3] = value & 0xFF;
+}
+
+// PBKDF2-HMAC-SHA256 of the passphrase
+static Status aead_derive(AeadKey *key, const char *passphrase, const unsigned char *salt, uint iterations)
+{
+    if (PKCS5_PBKDF2_HMAC(passphrase, strlen(passphrase), salt, AEAD_SALT_SIZE, iterations,
+                          EVP_sha256(), AEAD_KEY_SIZE, key->key) != 1)
+        return e_failure;
+    return e_success;
+}
+
+Status aead_read_passphrase(const char *fname, char *passphrase)
+{
+    FILE *fptr = fopen(fname, "r");
+    size_t len;
+
+    if (fptr == NULL)
+    {
+        perror("fopen ");
+        printf("ERROR ❌ : Unable to open passphrase file %s\n", fname);
+        return e_failure;
+    }
+
+    if (fgets(passphrase, AEAD_MAX_PASSPHRASE + 1, fptr) == NULL)
+        passphrase[0] = '\0';
+    fclose(fptr);
+
+    len = strcspn(passphrase, "\r\n");
+    passphrase[len] = '\0';
+    if (len == 0)
+    {
+        printf("ERROR ❌ : Passphrase file %s is empty\n", fname);
+        return e_failure;
+    }
+
+    return e_success;
+}
+
+Status aead_new_key(AeadKey *key, const char *passphrase, char *header)
+{
+    unsigned char *p = (unsigned char *)header;
+
+    if (RAND_bytes(p, AEAD_SALT_SIZE) != 1 || RAND_bytes(key->nonce, AEAD_NONCE_SIZE) != 1)
+        return e_failure;
+
+    put_be32(p + AEAD_SALT_SIZE, AEAD_ITERATIONS);
+    memcpy(p + AEAD_SALT_SIZE + 4, key->nonce, AEAD_NONCE_SIZE);
+
+    return aead_derive(key, passphrase, p, AEAD_ITERATIONS);
+}
+
+Status aead_load_key(AeadKey *key, const char *passphrase, const char *header)
+{
+    const unsigned char *p = (const unsigned char *)header;
+    uint iterations = ((uint)p[16] << 24) | (p[17] << 16) | (p[18] << 8) | p[19];
+
+    // Anything far past the default is a corrupt header rather than a slow key
+    if (iterations == 0 || iterations > 100 * AEAD_ITERATIONS)
+        return e_failure;
+
+    memcpy(key->nonce, p + AEAD_SALT_SIZE + 4, AEAD_NONCE_SIZE);
+    return aead_derive(key, passphrase, p, iterations);
+}
+
+long aead_stream_size(long plain_size)
+{
+    long records = plain_size > 0 ? (plain_size + AEAD_CHUNK - 1) / AEAD_CHUNK : 1;
+
+    return plain_size + records * AEAD_TAG_SIZE;
+}
+
+long aead_plain_size(long stream_size)
+{
+    long records = (stream_size + AEAD_RECORD - 1) / AEAD_RECORD;
+    long plain_size = stream_size - records * AEAD_TAG_SIZE;
+
+    if (records == 0 || plain_size < 0 || aead_stream_size(plain_size) != stream_size)
+        return -1;
+    return plain_size;
+}
+
+Status aead_init(Aead *aead, const AeadKey *key, int seal)
+{
+    aead->key = key;
+    aead->ctx = EVP_CIPHER_CTX_new();
+    if (aead->ctx == NULL)
+        return e_failure;
+
+    // Cipher, key and direction once, every record only sets its nonce
+    if (EVP_CipherInit_ex(aead->ctx, EVP_aes_256_gcm(), NULL, key->key, NULL, seal != 0) != 1)
+    {
+        EVP_CIPHER_CTX_free(aead->ctx);
+        aead->ctx = NULL;
+        return e_failure;
+    }
+
+    return e_success;
+}
+
+void aead_free(Aead *aead)
+{
+    EVP_CIPHER_CTX_free(aead->ctx);
+    aead->ctx = NULL;
+}
+
+// Record nonce (stored nonce with the index added into its low 8 bytes) and
+// associated data (index and last flag)
+static void aead_record_params(const Aead *aead, long index, int last, unsigned char *nonce, unsigned char *ad)
+{
+    unsigned long long value = index;
+    int i;
+
+    memcpy(nonce, aead->key->nonce, AEAD_NONCE_SIZE);
+    for (i = AEAD_NONCE_SIZE - 1; i >= AEAD_NONCE_SIZE - 8; i--, value >>= 8)
+        nonce[i] ^= value & 0xFF;
+
+    for (i = 7, value = index; i >= 0; i--, value >>= 8)
+        ad[i] = value & 0xFF;
+    ad[8] = last != 0;
+}
+
+Status aead_seal(Aead *aead, long index, int last, char *data, long size)
+{
+    unsigned char nonce[AEAD_NONCE_SIZE], ad[9];
+    int n;
+
+    aead_record_params(aead, index, last, nonce, ad);
+    if (EVP_CipherInit_ex(aead->ctx, NULL, NULL, NULL, nonce, -1) != 1 ||
+        EVP_EncryptUpdate(aead->ctx, NULL, &n, ad, sizeof(ad)) != 1 ||
+        (size > 0 && EVP_EncryptUpdate(aead->ctx, (unsigned char *)data, &n, (unsigned char *)data, size) != 1) ||
+        EVP_EncryptFinal_ex(aead->ctx, (unsigned char *)data + size, &n) != 1 ||
+        EVP_CIPHER_CTX_ctrl(aead->ctx, EVP_CTRL_GCM_GET_TAG, AEAD_TAG_SIZE, data + size) != 1)
+        return e_failure;
+
+    return e_success;
+}
+
+Status aead_open(Aead *aead, long index, int last, char *data, long size)
+{
+    unsigned char nonce[AEAD_NONCE_SIZE], ad[9];
+    int n;
+
+    aead_record_params(aead, index, last, nonce, ad);
+    if (EVP_CipherInit_ex(aead->ctx, NULL, NULL, NULL, nonce, -1) != 1 ||
+        EVP_DecryptUpdate(aead->ctx, NULL, &n, ad, sizeof(ad)) != 1 ||
+        (size > 0 && EVP_DecryptUpdate(aead->ctx, (unsigned char *)data, &n, (unsigned char *)data, size) != 1) ||
+        EVP_CIPHER_CTX_ctrl(aead->ctx, EVP_CTRL_GCM_SET_TAG, AEAD_TAG_SIZE, data + size) != 1 ||
+        EVP_DecryptFinal_ex(aead->ctx, (unsigned char *)data + size, &n) != 1)
+        return e_failure;
+
+    return e_success;
+}
@@ -0,0 +1,80 @@
+#ifndef AEAD_H
+#define AEAD_H
+
+#include "types.h"
+
+/*
+ * Passphrase encryption of the secret (STEGO_FLAG_ENCRYPTED, --passphrase FILE)
+ * AES-256-GCM through OpenSSL, which uses AES-NI and PCLMUL when the CPU has them.
+ * The key comes from the passphrase with PBKDF2-HMAC-SHA256. The secret is cut
+ * into records of AEAD_CHUNK bytes, each sealed on its own and stored as its
+ * ciphertext followed by its tag, so records can be sealed and opened in any
+ * order (-j stripes) as they are embedded / extracted. A record's nonce is the
+ * stored nonce with its index added in, and its index and a last record flag are
+ * authenticated, so records can't be reordered, dropped or cut off at the end.
+ * There is always a last record, an empty secret is one tag
+ *
+ * Crypto header, right after the secret size field, AEAD_HEADER_SIZE bytes :
+ *   salt (16) | PBKDF2 iterations (4, big endian) | nonce (12)
+ */
+
+#define AEAD_SALT_SIZE 16
+#define AEAD_NONCE_SIZE 12
+#define AEAD_TAG_SIZE 16
+#define AEAD_KEY_SIZE 32
+#define AEAD_HEADER_SIZE (AEAD_SALT_SIZE + 4 + AEAD_NONCE_SIZE)
+
+/* PBKDF2 iterations for new images, the count is stored so it can be raised later */
+#ifndef AEAD_ITERATIONS
+#define AEAD_ITERATIONS 200000
+#endif
+
+/* Secret bytes per record, a record plus its tag is a multiple of LSB_ALIGN (32760 bytes) */
+#define AEAD_CHUNK 32744
+#define AEAD_RECORD (AEAD_CHUNK + AEAD_TAG_SIZE)
+
+/* Longest passphrase read from the passphrase file */
+#define AEAD_MAX_PASSPHRASE 1024
+
+typedef struct
+{
+    unsigned char key[AEAD_KEY_SIZE];
+    unsigned char nonce[AEAD_NONCE_SIZE];
+} AeadKey;
+
+/* Cipher context of one thread, records are sealed / opened with it */
+typedef struct
+{
+    const AeadKey *key;
+    void *ctx;
+} Aead;
+
+/* Read the passphrase : the first line of fname, without the line end, into AEAD_MAX_PASSPHRASE + 1 bytes */
+Status aead_read_passphrase(const char *fname, char *passphrase);
+
+/* New random salt and nonce in header, and the key for them */
+Status aead_new_key(AeadKey *key, const char *passphrase, char *header);
+
+/* Key for the crypto header of an image */
+Status aead_load_key(AeadKey *key, const char *passphrase, const char *header);
+
+/* Bytes embedded for a secret of plain_size bytes, records and tags */
+long aead_stream_size(long plain_size);
+
+/* Secret bytes of an embedded stream of stream_size bytes, -1 if no secret has that size */
+long aead_plain_size(long stream_size);
+
+/* Context for sealing (seal 1, encoding) or opening (seal 0, decoding) records */
+Status aead_init(Aead *aead, const AeadKey *key, int seal);
+void aead_free(Aead *aead);
+
+/*
+ * Seal record index of size (up to AEAD_CHUNK) bytes in place, the tag goes
+ * to data + size. last marks the final record of the secret
+ */
+Status aead_seal(Aead *aead, long index, int last, char *data, long size);
+
+/* Open a record of size secret bytes plus tag in place, e_failure if it doesn't authenticate */
+Status aead_open(Aead *aead, long index, int last, char *data, long size);
+
+#endif
@@ -0,0 +1,404 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "batch.h"
+#include "encode.h"
+#include "common.h"
+
+/* One line of the manifest, or one cover of a directory pair (line 0) */
+typedef struct
+{
+    /* NULL for a malformed manifest line, which runs as a failed job */
+    char *cover;
+    char *secret;
+    char *output;
+    int line;
+    Status status;
+    double seconds;
+} BatchJob;
+
+/* State shared by the workers */
+typedef struct
+{
+    BatchJob *jobs;
+    int count;
+    int next;
+    int done;
+    const char *source;
+    const EncodeInfo *settings;
+    pthread_mutex_t lock;
+} BatchQueue;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Free the file names of count jobs and the list
+static void free_jobs(BatchJob *list, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        free(list[i].cover);
+        free(list[i].secret);
+        free(list[i].output);
+    }
+    free(list);
+}
+
+// Make room for one more job, returns 0 when out of memory
+static int grow_jobs(BatchJob **list, int count, int *size)
+{
+    BatchJob *grown;
+
+    if (count < *size)
+        return 1;
+
+    *size = *size ? *size * 2 : 64;
+    grown = realloc(*list, *size * sizeof(**list));
+    if (grown == NULL)
+        return 0;
+    *list = grown;
+    return 1;
+}
+
+// Read the manifest into jobs, returns the job count or -1 on error
+// Malformed lines are kept as jobs without a cover, so they are numbered and fail with the rest
+static int read_manifest(const char *fname, BatchJob **jobs)
+{
+    FILE *fptr;
+    char *line = NULL;
+    size_t cap = 0;
+    int count = 0, size = 0, lineno = 0, nomem = 0;
+    BatchJob *list = NULL;
+
+    fptr = fopen(fname, "r");
+    if (fptr == NULL)
+    {
+        perror("fopen ");
+        printf("ERROR ❌ : Unable to open manifest %s\n", fname);
+        return -1;
+    }
+
+    while (getline(&line, &cap, fptr) != -1)
+    {
+        char *cover, *secret, *output, *extra;
+
+        lineno++;
+        cover = strtok(line, " \t\r\n");
+        if (cover == NULL || cover[0] == '#')
+            continue;
+        secret = strtok(NULL, " \t\r\n");
+        output = strtok(NULL, " \t\r\n");
+        extra = strtok(NULL, " \t\r\n");
+
+        if (!grow_jobs(&list, count, &size))
+        {
+            nomem = 1;
+            break;
+        }
+
+        list[count].line = lineno;
+        list[count].status = e_failure;
+        list[count].seconds = 0;
+        if (secret == NULL || output == NULL || extra != NULL)
+        {
+            list[count].cover = list[count].secret = list[count].output = NULL;
+            count++;
+            continue;
+        }
+
+        list[count].cover = strdup(cover);
+        list[count].secret = strdup(secret);
+        list[count].output = strdup(output);
+        count++;
+        if (list[count - 1].cover == NULL || list[count - 1].secret == NULL || list[count - 1].output == NULL)
+        {
+            nomem = 1;
+            break;
+        }
+    }
+
+    free(line);
+
+    // Running part of the manifest would pass for the whole run
+    if (nomem || ferror(fptr))
+    {
+        printf("ERROR ❌ : Unable to read manifest %s past line %d\n", fname, lineno);
+        fclose(fptr);
+        free_jobs(list, count);
+        return -1;
+    }
+
+    fclose(fptr);
+    *jobs = list;
+    return count;
+}
+
+// Order the jobs of a directory pair by cover name
+static int compare_jobs(const void *a, const void *b)
+{
+    return strcmp(((const BatchJob *)a)->cover, ((const BatchJob *)b)->cover);
+}
+
+// Make a job of every NAME.bmp in cover_dir that has a NAME.txt, NAME.c or NAME.sh secret next to it
+// The stego image goes to out_dir/NAME.bmp, returns the job count or -1 on error
+static int read_directory_pair(const char *cover_dir, const char *out_dir, BatchJob **jobs)
+{
+    static const char *extns[] = { ".txt", ".c", ".sh" };
+    struct stat cover_st, out_st;
+    struct dirent *entry;
+    DIR *dir;
+    BatchJob *list = NULL;
+    char *secret;
+    size_t len, dir_len;
+    int count = 0, size = 0, nomem = 0, i;
+
+    if (stat(cover_dir, &cover_st) != 0 || !S_ISDIR(cover_st.st_mode))
+    {
+        printf("ERROR ❌ : %s is not a directory of covers\n", cover_dir);
+        return -1;
+    }
+
+    if (stat(out_dir, &out_st) != 0 || !S_ISDIR(out_st.st_mode))
+    {
+        printf("ERROR ❌ : %s is not a directory to write the stego images to\n", out_dir);
+        return -1;
+    }
+
+    // The stego images would replace their covers
+    if (cover_st.st_dev == out_st.st_dev && cover_st.st_ino == out_st.st_ino)
+    {
+        printf("ERROR ❌ : The output directory must differ from the cover directory\n");
+        return -1;
+    }
+
+    dir = opendir(cover_dir);
+    if (dir == NULL)
+    {
+        perror("opendir ");
+        printf("ERROR ❌ : Unable to open directory %s\n", cover_dir);
+        return -1;
+    }
+
+    dir_len = strlen(cover_dir);
+    while (!nomem && (entry = readdir(dir)) != NULL)
+    {
+        len = strlen(entry->d_name);
+        if (len <= 4 || strcmp(entry->d_name + len - 4, ".bmp") != 0)
+            continue;
+
+        // Room for cover_dir/NAME and the longest extension
+        secret = malloc(dir_len + len + 8);
+        if (secret == NULL)
+        {
+            nomem = 1;
+            break;
+        }
+
+        for (i = 0; i < (int)(sizeof(extns) / sizeof(extns[0])); i++)
+        {
+            sprintf(secret, "%s/%.*s%s", cover_dir, (int)(len - 4), entry->d_name, extns[i]);
+            if (access(secret, R_OK) == 0)
+                break;
+        }
+
+        // A cover without a secret is just a cover
+        if (i == (int)(sizeof(extns) / sizeof(extns[0])))
+        {
+            free(secret);
+            continue;
+        }
+
+        if (!grow_jobs(&list, count, &size))
+        {
+            free(secret);
+            nomem = 1;
+            break;
+        }
+
+        list[count].secret = secret;
+        list[count].cover = malloc(dir_len + len + 2);
+        list[count].output = malloc(strlen(out_dir) + len + 2);
+        list[count].line = 0;
+        list[count].status = e_failure;
+        list[count].seconds = 0;
+        count++;
+        if (list[count - 1].cover == NULL || list[count - 1].output == NULL)
+        {
+            nomem = 1;
+            break;
+        }
+        sprintf(list[count - 1].cover, "%s/%s", cover_dir, entry->d_name);
+        sprintf(list[count - 1].output, "%s/%s", out_dir, entry->d_name);
+    }
+
+    closedir(dir);
+
+    if (nomem)
+    {
+        printf("ERROR ❌ : Unable to list %s\n", cover_dir);
+        free_jobs(list, count);
+        return -1;
+    }
+
+    if (count > 1)
+        qsort(list, count, sizeof(*list), compare_jobs);
+    *jobs = list;
+    return count;
+}
+
+// Encode one job, the worker's arena is lent to the job and taken back afterwards
+static Status run_job(BatchJob *job, char **arena, size_t *arena_size, const EncodeInfo *settings)
+{
+    EncodeInfo encInfo;
+    char *argv[] = { "batch", "-e", job->cover, job->secret, job->output, NULL };
+    Status status;
+
+    if (job->cover == NULL)
+        return e_failure;
+
+    if (read_and_validate_encode_args(argv, &encInfo) == e_failure)
+        return e_failure;
+
+    encInfo.use_mmap = settings->use_mmap;
+    encInfo.depth = settings->depth;
+    encInfo.flags |= settings->flags;
+    encInfo.threads = 1;
+    encInfo.pipelined = 0;
+    encInfo.arena = *arena;
+    encInfo.arena_size = *arena_size;
+
+    status = do_encoding(&encInfo);
+
+    *arena = encInfo.arena;
+    *arena_size = encInfo.arena_size;
+    encInfo.arena = NULL;
+    close_enc_files(&encInfo);
+
+    return status;
+}
+
+// Worker : keeps taking the next job until the queue is empty
+static void *batch_worker(void *data)
+{
+    BatchQueue *queue = data;
+    BatchJob *job;
+    char *arena = NULL;
+    size_t arena_size = 0;
+    double start;
+    int index;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&queue->lock);
+        index = queue->next < queue->count ? queue->next++ : -1;
+        pthread_mutex_unlock(&queue->lock);
+
+        if (index < 0)
+            break;
+
+        job = &queue->jobs[index];
+        start = now_seconds();
+        job->status = run_job(job, &arena, &arena_size, queue->settings);
+        job->seconds = now_seconds() - start;
+
+        pthread_mutex_lock(&queue->lock);
+        queue->done++;
+        if (job->cover == NULL)
+            printf("FAIL ❌ [%d/%d] %s:%d : expected <cover.bmp> <secret> <output.bmp>\n",
+                   queue->done, queue->count, queue->source, job->line);
+        else
+            printf("%s [%d/%d] %s + %s -> %s (%.3f s)\n", job->status == e_success ? "OK   ✅" : "FAIL ❌",
+                   queue->done, queue->count, job->cover, job->secret, job->output, job->seconds);
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    free(arena);
+    return NULL;
+}
+
+// Run all jobs of the manifest, or of the directory pair when out_dir is given
+Status do_batch(const char *source, const char *out_dir, int threads, const EncodeInfo *settings)
+{
+    BatchQueue queue;
+    pthread_t *tids;
+    int i, started, failed, saved_quiet = stego_quiet;
+    double start;
+
+    if (out_dir != NULL)
+        queue.count = read_directory_pair(source, out_dir, &queue.jobs);
+    else
+        queue.count = read_manifest(source, &queue.jobs);
+    if (queue.count < 0)
+        return e_failure;
+
+    queue.next = 0;
+    queue.done = 0;
+    queue.source = source;
+    queue.settings = settings;
+    pthread_mutex_init(&queue.lock, NULL);
+
+    if (threads > queue.count)
+        threads = queue.count;
+    if (threads < 1)
+        threads = 1;
+
+    INFO_PRINTF("INFO 🚀 : ## Batch of %d jobs on %d threads ##\n\n", queue.count, threads);
+
+    // Per-stage messages of concurrent jobs would interleave, only job status is reported
+    stego_quiet = 1;
+    start = now_seconds();
+
+    tids = calloc(threads, sizeof(*tids));
+    started = 0;
+    while (tids != NULL && started < threads - 1 && pthread_create(&tids[started], NULL, batch_worker, &queue) == 0)
+        started++;
+
+    batch_worker(&queue);
+
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+
+    stego_quiet = saved_quiet;
+
+    failed = 0;
+    for (i = 0; i < queue.count; i++)
+    {
+        if (queue.jobs[i].status == e_failure)
+        {
+            failed++;
+            if (queue.jobs[i].line == 0)
+                printf("ERROR ❌ : %s failed\n", queue.jobs[i].cover);
+            else
+                printf("ERROR ❌ : %s line %d failed : %s\n", source, queue.jobs[i].line,
+                       queue.jobs[i].cover != NULL ? queue.jobs[i].cover : "malformed line");
+        }
+    }
+
+    printf("\nINFO 📊 : Batch summary : %d jobs, %d succeeded, %d failed, %.3f s\n\n",
+           queue.count, queue.count - failed, failed, now_seconds() - start);
+
+    free_jobs(queue.jobs, queue.count);
+    free(tids);
+    pthread_mutex_destroy(&queue.lock);
+
+    return failed ? e_failure : e_success;
+}
@@ -0,0 +1,22 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "types.h"
+#include "encode.h"
+
+/*
+ * Batch mode : run many encodings in one process
+ * The manifest has one job per line : <cover.bmp> <secret file> <output.bmp>
+ * Blank lines and lines starting with '#' are skipped
+ * A directory pair <cover_dir> <out_dir> encodes every NAME.bmp of cover_dir that has a
+ * NAME.txt, NAME.c or NAME.sh secret next to it into out_dir/NAME.bmp
+ */
+
+/*
+ * Run every job of the manifest (out_dir NULL) or of the directory pair source, out_dir
+ * on a pool of threads, prints per job status and a summary
+ * settings supplies the encode options shared by all jobs (use_mmap, depth)
+ */
+Status do_batch(const char *source, const char *out_dir, int threads, const EncodeInfo *settings);
+
+#endif
@@ -0,0 +1,674 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project - encode / decode benchmark
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "encode.h"
+#include "decode.h"
+#include "common.h"
+#include "stats.h"
+#include "lsb.h"
+
+/*
+ * Builds synthetic covers and payloads, then runs do_encoding() and
+ * do_decoding() on every combination that fits. Each run happens in a
+ * forked child so its peak RSS is its own. Results go to stdout as a
+ * table and to a JSON file for comparing releases
+ * --kernels instead times the LSB kernels alone, in memory, and --copy
+ * the copy of the cover bytes left after the payload
+ */
+
+#define BENCH_MAX_DEPTHS 4
+#define BENCH_BLOCK (1 << 20)
+
+/* Synthetic covers, in megapixels */
+static const struct { int mp, width, height; } bench_covers[] = {
+    { 1, 1000, 1000 },
+    { 12, 4000, 3000 },
+    { 50, 10000, 5000 },
+    { 200, 20000, 10000 },
+};
+
+/* Synthetic payloads */
+static const struct { const char *name; long size; } bench_payloads[] = {
+    { "1K", 1L << 10 },
+    { "1M", 1L << 20 },
+    { "64M", 64L << 20 },
+    { "1G", 1L << 30 },
+};
+
+/* LSB kernels timed by --kernels with the depths each one has, and the payload each run goes over (64 MB of cover at depth 1) */
+static const struct { LsbKernel kernel; const char *name; int min_depth, max_depth; } bench_kernels[] = {
+    { LSB_KERNEL_SCALAR, "scalar", 1, 4 },
+    { LSB_KERNEL_SSE2, "sse2", 1, 1 },
+    { LSB_KERNEL_SSSE3, "ssse3", 2, 4 },
+    { LSB_KERNEL_AVX2, "avx2", 1, 4 },
+};
+#define BENCH_KERNEL_PAYLOAD (8L << 20)
+#define BENCH_KERNEL_REPS 5
+
+/* Cover for --copy, about 100 MB of pixels */
+#define BENCH_COPY_WIDTH 7000
+#define BENCH_COPY_HEIGHT 5000
+
+#define BENCH_NKERNELS (int)(sizeof(bench_kernels) / sizeof(bench_kernels[0]))
+#define BENCH_NCOVERS (int)(sizeof(bench_covers) / sizeof(bench_covers[0]))
+#define BENCH_NPAYLOADS (int)(sizeof(bench_payloads) / sizeof(bench_payloads[0]))
+
+/* What a child reports back for one run */
+typedef struct
+{
+    Status status;
+    long max_rss_kb;
+    StegoStats stats;
+} BenchResult;
+
+typedef struct
+{
+    const char *dir;
+    const char *json_fname;
+    int max_mp;
+    long max_payload;
+    int depths[BENCH_MAX_DEPTHS];
+    int ndepths;
+    int use_mmap;
+    int threads;
+    int kernels;
+    int copy;
+} BenchOptions;
+
+static Status bench_encode(const char *cover, const char *secret, const char *output, int depth,
+                           const BenchOptions *opts, BenchResult *result)
+{
+    EncodeInfo encInfo;
+    char *argv[] = { "bench", "-e", (char *)cover, (char *)secret, (char *)output, NULL };
+    Status status;
+
+    result->status = e_failure;
+    stats_begin(&result->stats, "encode");
+    if (read_and_validate_encode_args(argv, &encInfo) == e_failure)
+    {
+        stats_end(&result->stats);
+        return e_failure;
+    }
+    encInfo.use_mmap = opts->use_mmap;
+    encInfo.threads = opts->threads;
+    encInfo.depth = depth;
+
+    status = do_encoding(&encInfo);
+    close_enc_files(&encInfo);
+    stats_end(&result->stats);
+    result->status = status;
+    return status;
+}
+
+static Status bench_decode(const char *stego, const char *output, const BenchOptions *opts, BenchResult *result)
+{
+    DecodeInfo decInfo;
+    char *argv[] = { "bench", "-d", (char *)stego, (char *)output, NULL };
+    Status status;
+
+    result->status = e_failure;
+    stats_begin(&result->stats, "decode");
+    if (read_and_validate_decode_args(argv, &decInfo) == e_failure)
+    {
+        stats_end(&result->stats);
+        return e_failure;
+    }
+    decInfo.use_mmap = opts->use_mmap;
+    decInfo.threads = opts->threads;
+
+    status = do_decoding(&decInfo);
+    close_dec_files(&decInfo);
+    stats_end(&result->stats);
+    result->status = status;
+    return status;
+}
+
+// Run one encode (output != NULL) or decode in a child, fill result and its peak RSS
+static Status bench_fork(const char *input, const char *secret, const char *output, int depth,
+                         const BenchOptions *opts, BenchResult *result)
+{
+    struct rusage usage;
+    int fds[2], wstatus;
+    pid_t pid;
+    ssize_t got;
+
+    if (pipe(fds) != 0)
+    {
+        perror("pipe ");
+        return e_failure;
+    }
+
+    fflush(stdout);
+    pid = fork();
+    if (pid < 0)
+    {
+        perror("fork ");
+        close(fds[0]);
+        close(fds[1]);
+        return e_failure;
+    }
+
+    if (pid == 0)
+    {
+        BenchResult child;
+
+        close(fds[0]);
+        if (secret != NULL)
+            bench_encode(input, secret, output, depth, opts, &child);
+        else
+            bench_decode(input, output, opts, &child);
+        if (write(fds[1], &child, sizeof(child)) != sizeof(child))
+            _exit(1);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    got = read(fds[0], result, sizeof(*result));
+    close(fds[0]);
+
+    if (wait4(pid, &wstatus, 0, &usage) < 0 || got != sizeof(*result))
+    {
+        printf("ERROR ❌ : Benchmark run for %s didn't report back\n", input);
+        return e_failure;
+    }
+
+    // ru_maxrss of a waited child is that child's own peak, in kB on Linux
+    result->max_rss_kb = usage.ru_maxrss;
+    return result->status;
+}
+
+// Fill buf with xorshift noise, fast and incompressible
+static void fill_random(char *buf, size_t size, unsigned long *state)
+{
+    unsigned long x = *state;
+    size_t i;
+
+    for (i = 0; i + sizeof(x) <= size; i += sizeof(x))
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        memcpy(buf + i, &x, sizeof(x));
+    }
+    for (; i < size; i++)
+        buf[i] = (char)(x >> (8 * (i % sizeof(x))));
+    *state = x;
+}
+
+// Write a synthetic file of header + size random bytes unless one of the right size exists
+static Status make_file(const char *fname, const char *header, long header_size, long size, unsigned long seed)
+{
+    struct stat st;
+    FILE *fptr;
+    char *buf;
+    long left;
+
+    if (stat(fname, &st) == 0 && st.st_size == header_size + size)
+        return e_success;
+
+    fptr = fopen(fname, "w");
+    buf = malloc(BENCH_BLOCK);
+    if (fptr == NULL || buf == NULL)
+    {
+        perror("fopen ");
+        printf("ERROR ❌ : Unable to create %s\n", fname);
+        if (fptr != NULL)
+            fclose(fptr);
+        free(buf);
+        return e_failure;
+    }
+
+    if (header_size > 0)
+        fwrite(header, 1, header_size, fptr);
+    for (left = size; left > 0; left -= BENCH_BLOCK)
+    {
+        long chunk = left < BENCH_BLOCK ? left : BENCH_BLOCK;
+
+        fill_random(buf, chunk, &seed);
+        if (fwrite(buf, 1, chunk, fptr) != (size_t)chunk)
+            break;
+    }
+
+    free(buf);
+    if (fclose(fptr) != 0 || left > 0)
+    {
+        printf("ERROR ❌ : Unable to write %s\n", fname);
+        unlink(fname);
+        return e_failure;
+    }
+    return e_success;
+}
+
+static void put_le(char *p, unsigned long value, int bytes)
+{
+    int i;
+
+    for (i = 0; i < bytes; i++)
+        p[i] = (value >> (8 * i)) & 0xFF;
+}
+
+// 24-bit bottom-up BMP of width x height with noise pixels
+static Status make_cover(const char *fname, int width, int height)
+{
+    char header[BMP_HEADER_SIZE] = { 'B', 'M' };
+    long row = ((long)width * 3 + 3) & ~3L;
+    long pixels = row * height;
+
+    put_le(header + 2, BMP_HEADER_SIZE + pixels, 4);
+    put_le(header + 10, BMP_HEADER_SIZE, 4);
+    put_le(header + 14, BMP_INFO_HEADER_SIZE, 4);
+    put_le(header + 18, width, 4);
+    put_le(header + 22, height, 4);
+    put_le(header + 26, 1, 2);
+    put_le(header + 28, 24, 2);
+    put_le(header + 34, pixels, 4);
+
+    return make_file(fname, header, BMP_HEADER_SIZE, pixels, 0x9E3779B97F4A7C15UL ^ (unsigned long)width);
+}
+
+static double bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Best of BENCH_KERNEL_REPS passes of lsb_extract() (extract set) or lsb_embed() over the buffers, in GB/s of cover bytes
+static double bench_kernel_pass(int extract, char *payload, char *cover, long size, int depth)
+{
+    double best = 0, t;
+    int r;
+
+    for (r = 0; r < BENCH_KERNEL_REPS; r++)
+    {
+        t = bench_now();
+        if (extract)
+            lsb_extract(payload, size, cover, depth);
+        else
+            lsb_embed(payload, size, cover, depth);
+        t = bench_now() - t;
+        if (best == 0 || t < best)
+            best = t;
+    }
+    return best > 0 ? LSB_COVER_SIZE(size, depth) / 1e9 / best : 0.0;
+}
+
+// --kernels : embed and extract throughput of every LSB kernel the CPU has, at every depth
+// Each kernel's stego bytes and extracted payload are checked against the scalar kernel's
+static int bench_kernels_run(void)
+{
+    long size = BENCH_KERNEL_PAYLOAD, max_cover = LSB_COVER_SIZE(size, LSB_MIN_DEPTH);
+    char *payload = malloc(size), *back = malloc(size), *cover = malloc(max_cover), *expect = malloc(max_cover);
+    unsigned long seed = 0x2545F4914F6CDD1DUL, cover_seed;
+    int k, depth, failed = 0;
+
+    if (payload == NULL || back == NULL || cover == NULL || expect == NULL)
+    {
+        printf("ERROR ❌ : Can't allocate kernel benchmark buffers 🧠\n");
+        free(payload);
+        free(back);
+        free(cover);
+        free(expect);
+        return 1;
+    }
+    fill_random(payload, size, &seed);
+
+    printf("%-7s %-5s | %11s %12s\n", "kernel", "depth", "embed GB/s", "extract GB/s");
+    for (depth = LSB_MIN_DEPTH; depth <= LSB_MAX_DEPTH; depth++)
+    {
+        long n = LSB_COVER_SIZE(size, depth);
+
+        // Reference stego bytes from the scalar kernel, every kernel starts from the same cover
+        cover_seed = seed;
+        fill_random(expect, n, &seed);
+        lsb_set_kernel(LSB_KERNEL_SCALAR);
+        lsb_embed(payload, size, expect, depth);
+
+        for (k = 0; k < BENCH_NKERNELS; k++)
+        {
+            double embed, extract;
+            unsigned long s = cover_seed;
+            int ok;
+
+            // SSE2 only has depth 1, SSSE3 only depths 2 to 4, the other depth would time a fallback
+            if (depth < bench_kernels[k].min_depth || depth > bench_kernels[k].max_depth || !lsb_set_kernel(bench_kernels[k].kernel))
+            {
+                printf("%-7s %-5d | %11s %12s\n", bench_kernels[k].name, depth, "-", "-");
+                continue;
+            }
+
+            fill_random(cover, n, &s);
+            memset(back, 0, size);
+            embed = bench_kernel_pass(0, payload, cover, size, depth);
+            extract = bench_kernel_pass(1, back, cover, size, depth);
+            ok = memcmp(cover, expect, n) == 0 && memcmp(back, payload, size) == 0;
+            if (!ok)
+                failed++;
+
+            printf("%-7s %-5d | %11.2f %12.2f%s\n", bench_kernels[k].name, depth, embed, extract, ok ? "" : "  MISMATCH ❌");
+        }
+    }
+
+    lsb_set_kernel(LSB_KERNEL_AUTO);
+    free(payload);
+    free(back);
+    free(cover);
+    free(expect);
+    return failed ? 1 : 0;
+}
+
+// The copy copy_remaining_img_data() replaced : one byte per fread / fwrite
+static Status copy_per_byte(FILE *fptr_src, FILE *fptr_dest)
+{
+    char ch;
+
+    while (fread(&ch, 1, 1, fptr_src) == 1)
+        if (fwrite(&ch, 1, 1, fptr_dest) != 1)
+            return e_failure;
+    return ferror(fptr_src) ? e_failure : e_success;
+}
+
+// Feed fname into a pipe from a child, so the copy sees a stream like a cover read from stdin
+static FILE *open_piped(const char *fname, pid_t *pid)
+{
+    int fds[2], fd;
+    char *buf;
+    ssize_t n;
+
+    if (pipe(fds) != 0)
+        return NULL;
+
+    fflush(stdout);
+    *pid = fork();
+    if (*pid == 0)
+    {
+        close(fds[0]);
+        fd = open(fname, O_RDONLY);
+        buf = malloc(BENCH_BLOCK);
+        if (fd < 0 || buf == NULL)
+            _exit(1);
+        while ((n = read(fd, buf, BENCH_BLOCK)) > 0)
+            if (write(fds[1], buf, n) != n)
+                _exit(1);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    if (*pid < 0)
+    {
+        close(fds[0]);
+        return NULL;
+    }
+    return fdopen(fds[0], "r");
+}
+
+// --copy : copy the pixels of a 100 MB cover after its header, per byte (the old copy), through
+// copy_remaining_img_data() from a pipe (user space buffer) and from the file (copy_file_range / sendfile)
+static int bench_copy_run(const BenchOptions *opts)
+{
+    static const char *names[] = { "per-byte", "buffered (pipe)", "kernel" };
+    char cover[512], output[512], header[BMP_HEADER_SIZE];
+    long pixels = ((BENCH_COPY_WIDTH * 3L + 3) & ~3L) * BENCH_COPY_HEIGHT;
+    FILE *fptr_src, *fptr_dest;
+    struct stat st;
+    pid_t pid = -1;
+    double start, seconds;
+    Status status;
+    int m, failed = 0;
+
+    snprintf(cover, sizeof(cover), "%s/cover_copy.bmp", opts->dir);
+    snprintf(output, sizeof(output), "%s/copy.bmp", opts->dir);
+    if (make_cover(cover, BENCH_COPY_WIDTH, BENCH_COPY_HEIGHT) == e_failure)
+        return 1;
+
+    // Warm the page cache so every way reads the cover from memory
+    fptr_src = fopen(cover, "r");
+    fptr_dest = fopen("/dev/null", "w");
+    if (fptr_src == NULL || fptr_dest == NULL || copy_remaining_img_data(fptr_src, fptr_dest) == e_failure)
+    {
+        printf("ERROR ❌ : Unable to read %s\n", cover);
+        return 1;
+    }
+    fclose(fptr_src);
+    fclose(fptr_dest);
+
+    printf("%-16s | %10s %9s\n", "copy", "MB/s", "seconds");
+    for (m = 0; m < 3; m++)
+    {
+        start = bench_now();
+        fptr_src = m == 1 ? open_piped(cover, &pid) : fopen(cover, "r");
+        fptr_dest = fopen(output, "w");
+        status = e_failure;
+
+        // The header stands for what do_encoding() has gone past when the copy starts
+        if (fptr_src != NULL && fptr_dest != NULL &&
+            fread(header, BMP_HEADER_SIZE, 1, fptr_src) == 1 && fwrite(header, BMP_HEADER_SIZE, 1, fptr_dest) == 1)
+            status = m == 0 ? copy_per_byte(fptr_src, fptr_dest) : copy_remaining_img_data(fptr_src, fptr_dest);
+        if (fptr_src != NULL)
+            fclose(fptr_src);
+        if (fptr_dest != NULL && fclose(fptr_dest) != 0)
+            status = e_failure;
+        if (m == 1 && pid > 0)
+            waitpid(pid, NULL, 0);
+        seconds = bench_now() - start;
+
+        if (status == e_success && (stat(output, &st) != 0 || st.st_size != BMP_HEADER_SIZE + pixels))
+            status = e_failure;
+        if (status == e_failure)
+            failed++;
+
+        printf("%-16s | %10.1f %9.3f%s\n", names[m], pixels / 1e6 / seconds, seconds, status == e_success ? "" : "  FAIL ❌");
+        unlink(output);
+    }
+
+    return failed ? 1 : 0;
+}
+
+static void json_run(FILE *fptr, const char *op, const BenchResult *result, long payload)
+{
+    const StegoStats *stats = &result->stats;
+
+    fprintf(fptr, "\"%s\": {\"ok\": %s, \"mb_per_s\": %.2f, \"max_rss_kb\": %ld, \"stats\": ",
+            op, result->status == e_success ? "true" : "false",
+            stats->seconds > 0 ? payload / 1e6 / stats->seconds : 0.0, result->max_rss_kb);
+    stats_print_json(stats, fptr);
+    fprintf(fptr, "}");
+}
+
+// Parse a byte count with an optional K / M / G suffix
+static long parse_size(const char *arg)
+{
+    char *end;
+    long value = strtol(arg, &end, 10);
+
+    switch (*end)
+    {
+        case 'K': case 'k': value <<= 10; end++; break;
+        case 'M': case 'm': value <<= 20; end++; break;
+        case 'G': case 'g': value <<= 30; end++; break;
+    }
+    return *end == '\0' && value > 0 ? value : -1;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage : %s [--quick] [--max-mp N] [--max-payload SIZE] [--depth N]... [--mmap] [-j N]\n"
+           "        [--dir DIR] [--json FILE]\n"
+           "        %s --kernels\n"
+           "        %s --copy [--dir DIR]\n", prog, prog, prog);
+}
+
+static Status parse_options(int argc, char *argv[], BenchOptions *opts)
+{
+    int i;
+
+    memset(opts, 0, sizeof(*opts));
+    opts->dir = "/tmp/stego-bench";
+    opts->json_fname = "bench.json";
+    opts->max_mp = 200;
+    opts->max_payload = 1L << 30;
+    opts->threads = 1;
+
+    for (i = 1; i < argc; i++)
+    {
+        const char *next = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--quick") == 0)
+        {
+            opts->max_mp = 12;
+            opts->max_payload = 1L << 20;
+        }
+        else if (strcmp(argv[i], "--mmap") == 0)
+            opts->use_mmap = 1;
+        else if (strcmp(argv[i], "--kernels") == 0)
+            opts->kernels = 1;
+        else if (strcmp(argv[i], "--copy") == 0)
+            opts->copy = 1;
+        else if (strcmp(argv[i], "--max-mp") == 0 && next && (opts->max_mp = atoi(next)) > 0)
+            i++;
+        else if (strcmp(argv[i], "--max-payload") == 0 && next && (opts->max_payload = parse_size(next)) > 0)
+            i++;
+        else if (strcmp(argv[i], "-j") == 0 && next && (opts->threads = atoi(next)) > 0)
+            i++;
+        else if (strcmp(argv[i], "--dir") == 0 && next)
+            opts->dir = argv[++i];
+        else if (strcmp(argv[i], "--json") == 0 && next)
+            opts->json_fname = argv[++i];
+        else if (strcmp(argv[i], "--depth") == 0 && next && opts->ndepths < BENCH_MAX_DEPTHS &&
+                 atoi(next) >= LSB_MIN_DEPTH && atoi(next) <= LSB_MAX_DEPTH)
+            opts->depths[opts->ndepths++] = atoi(argv[++i]);
+        else
+        {
+            usage(argv[0]);
+            return e_failure;
+        }
+    }
+
+    if (opts->ndepths == 0)
+    {
+        opts->depths[opts->ndepths++] = 1;
+        opts->depths[opts->ndepths++] = 4;
+    }
+    return e_success;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions opts;
+    BenchResult enc, dec;
+    FILE *json;
+    char cover[512], secret[512], stego[512], output[512], decoded[512];
+    int c, p, d, first = 1, failed = 0;
+    struct stat st;
+
+    if (parse_options(argc, argv, &opts) == e_failure)
+        return 1;
+
+    if (opts.kernels)
+        return bench_kernels_run();
+
+    // Progress lines would dominate the small cases
+    stego_quiet = 1;
+
+    if (mkdir(opts.dir, 0755) != 0 && stat(opts.dir, &st) != 0)
+    {
+        perror("mkdir ");
+        return 1;
+    }
+
+    if (opts.copy)
+        return bench_copy_run(&opts);
+
+    json = fopen(opts.json_fname, "w");
+    if (json == NULL)
+    {
+        perror("fopen ");
+        return 1;
+    }
+    fprintf(json, "{\"stego_version\": %d, \"mmap\": %s, \"threads\": %d, \"cases\": [\n",
+            STEGO_VERSION, opts.use_mmap ? "true" : "false", opts.threads);
+
+    printf("%-6s %-6s %-5s | %10s %9s %9s | %10s %9s %9s\n", "cover", "secret", "depth",
+           "enc MB/s", "enc RSS", "enc calls", "dec MB/s", "dec RSS", "dec calls");
+
+    for (c = 0; c < BENCH_NCOVERS && bench_covers[c].mp <= opts.max_mp; c++)
+    {
+        long cover_bytes;
+
+        snprintf(cover, sizeof(cover), "%s/cover_%dmp.bmp", opts.dir, bench_covers[c].mp);
+        if (make_cover(cover, bench_covers[c].width, bench_covers[c].height) == e_failure)
+            return 1;
+        cover_bytes = (((long)bench_covers[c].width * 3 + 3) & ~3L) * bench_covers[c].height;
+
+        for (p = 0; p < BENCH_NPAYLOADS && bench_payloads[p].size <= opts.max_payload; p++)
+        {
+            long size = bench_payloads[p].size;
+
+            snprintf(secret, sizeof(secret), "%s/payload_%s.txt", opts.dir, bench_payloads[p].name);
+            snprintf(stego, sizeof(stego), "%s/stego.bmp", opts.dir);
+            snprintf(output, sizeof(output), "%s/decoded", opts.dir);
+            snprintf(decoded, sizeof(decoded), "%s/decoded.txt", opts.dir);
+
+            for (d = 0; d < opts.ndepths; d++)
+            {
+                int depth = opts.depths[d];
+
+                // Headers take well under a kilobyte of cover, skip what can't fit
+                if ((long)LSB_COVER_SIZE(size, depth) + 1024 > cover_bytes)
+                    continue;
+                if (make_file(secret, NULL, 0, size, 0xD1B54A32D192ED03UL ^ (unsigned long)size) == e_failure)
+                    return 1;
+
+                memset(&dec, 0, sizeof(dec));
+                dec.status = e_failure;
+                if (bench_fork(cover, secret, stego, depth, &opts, &enc) == e_success)
+                    bench_fork(stego, NULL, output, depth, &opts, &dec);
+
+                // Decoded size must match, contents are the round trip test's job
+                if (dec.status == e_success && (stat(decoded, &st) != 0 || st.st_size != size))
+                    dec.status = e_failure;
+                if (enc.status == e_failure || dec.status == e_failure)
+                    failed++;
+
+                printf("%-6d %-6s %-5d | %10.1f %8ldk %9ld | %10.1f %8ldk %9ld%s\n",
+                       bench_covers[c].mp, bench_payloads[p].name, depth,
+                       enc.stats.seconds > 0 ? size / 1e6 / enc.stats.seconds : 0.0, enc.max_rss_kb, enc.stats.syscalls,
+                       dec.stats.seconds > 0 ? size / 1e6 / dec.stats.seconds : 0.0, dec.max_rss_kb, dec.stats.syscalls,
+                       enc.status == e_success && dec.status == e_success ? "" : "  FAIL ❌");
+
+                fprintf(json, "%s  {\"cover_mp\": %d, \"cover_bytes\": %ld, \"payload_bytes\": %ld, \"depth\": %d, ",
+                        first ? "" : ",\n", bench_covers[c].mp, cover_bytes, size, depth);
+                json_run(json, "encode", &enc, size);
+                fprintf(json, ", ");
+                json_run(json, "decode", &dec, size);
+                fprintf(json, "}");
+                first = 0;
+
+                unlink(stego);
+                unlink(decoded);
+            }
+        }
+    }
+
+    fprintf(json, "\n]}\n");
+    fclose(json);
+    printf("\nINFO 📊 : Results written to %s\n", opts.json_fname);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project
+*/
+
+#include <string.h>
+#include "bmp.h"
+
+/* biCompression values for uncompressed pixels */
+#define BI_RGB 0
+#define BI_BITFIELDS 3
+#define BI_ALPHABITFIELDS 6
+
+// Little endian fields, independent of the host byte order
+static uint bmp_u16(const char *p)
+{
+    const unsigned char *b = (const unsigned char *)p;
+
+    return b[0] | (b[1] << 8);
+}
+
+static uint bmp_u32(const char *p)
+{
+    const unsigned char *b = (const unsigned char *)p;
+
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint)b[3] << 24);
+}
+
+// Parse BITMAPFILEHEADER and the start of the info header
+Status bmp_parse_header(const char *header, size_t size, BmpInfo *info)
+{
+    uint compression;
+    long height;
+
+    memset(info, 0, sizeof(*info));
+
+    if (size < BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_SIZE || header[0] != 'B' || header[1] != 'M')
+    {
+        info->error = "not a BMP image";
+        return e_failure;
+    }
+
+    info->pixel_offset = bmp_u32(header + 10);
+    info->info_size = bmp_u32(header + 14);
+    info->width = (int)bmp_u32(header + 18);
+    height = (int)bmp_u32(header + 22);
+    info->bpp = bmp_u16(header + 28);
+    compression = bmp_u32(header + 30);
+
+    // OS/2 BITMAPCOREHEADER (12 bytes) has 16 bit sizes and isn't supported
+    if (info->info_size < BMP_INFO_HEADER_SIZE)
+    {
+        info->error = "unsupported BMP info header";
+        return e_failure;
+    }
+
+    if (info->bpp != 24 && info->bpp != 32)
+    {
+        info->error = "only 24-bit and 32-bit BMP images are supported";
+        return e_failure;
+    }
+
+    if (!(compression == BI_RGB || (info->bpp == 32 && (compression == BI_BITFIELDS || compression == BI_ALPHABITFIELDS))))
+    {
+        info->error = "compressed BMP images are not supported";
+        return e_failure;
+    }
+
+    if (info->width <= 0 || height == 0)
+    {
+        info->error = "invalid BMP dimensions";
+        return e_failure;
+    }
+
+    // Negative height : rows are stored top-down, which doesn't change where the bytes are
+    info->height = height < 0 ? -height : height;
+
+    // Pixels can't start inside the headers, and the headers are kept in memory
+    if (info->pixel_offset < BMP_FILE_HEADER_SIZE + info->info_size || info->pixel_offset > BMP_MAX_HEADER_SIZE)
+    {
+        info->error = "invalid BMP pixel data offset";
+        return e_failure;
+    }
+
+    // Every row is padded to a multiple of 4 bytes
+    info->row_size = ((long)info->width * info->bpp + 31) / 32 * 4;
+    info->pixel_span = info->row_size * info->height;
+    info->carriers = (long)info->width * 3 * info->height;
+
+    return e_success;
+}
+
+int bmp_has_gaps(const BmpInfo *info)
+{
+    return info->carriers != info->pixel_span;
+}
+
+long bmp_carrier_end(const BmpInfo *info, long size)
+{
+    long line = (long)info->width * 3, rel = size - info->pixel_offset, rest;
+
+    if (rel >= info->pixel_span)
+        return info->pixel_offset + info->carriers;
+    if (rel <= 0)
+        return info->pixel_offset;
+
+    // Whole rows, then the colour bytes of the partial one
+    rest = rel % info->row_size;
+    if (info->bpp == 32)
+        rest = rest / 4 * 3 + (rest % 4 < 3 ? rest % 4 : 3);
+    return info->pixel_offset + rel / info->row_size * line + (rest < line ? rest : line);
+}
+
+// Copy n colour bytes between carrier offset pos of map and buf, into map when put is set
+// 24-bit rows are copied in one go, 32-bit pixels leave their alpha byte alone
+static void bmp_copy(const BmpInfo *info, char *map, long pos, long n, char *buf, int put)
+{
+    long line = (long)info->width * 3, row, k, len, i;
+    char *pixels;
+
+    pos -= info->pixel_offset;
+    row = pos / line;
+    k = pos % line;
+    for (; n > 0; row++, k = 0, buf += len, n -= len)
+    {
+        len = line - k < n ? line - k : n;
+        pixels = map + info->pixel_offset + row * info->row_size;
+        if (info->bpp == 24)
+        {
+            if (put)
+                memcpy(pixels + k, buf, len);
+            else
+                memcpy(buf, pixels + k, len);
+            continue;
+        }
+
+        for (i = 0; i < len; i++, k++)
+        {
+            if (put)
+                pixels[k / 3 * 4 + k % 3] = buf[i];
+            else
+                buf[i] = pixels[k / 3 * 4 + k % 3];
+        }
+    }
+}
+
+void bmp_gather(const BmpInfo *info, const char *map, long pos, long n, char *buf)
+{
+    bmp_copy(info, (char *)map, pos, n, buf, 0);
+}
+
+void bmp_put(const BmpInfo *info, char *map, long pos, long n, const char *buf)
+{
+    bmp_copy(info, map, pos, n, (char *)buf, 1);
+}
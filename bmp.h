@@ -0,0 +1,59 @@
+#ifndef BMP_H
+#define BMP_H
+
+#include <stddef.h>
+#include "types.h"
+
+/*
+ * BMP header parsing
+ * Supports uncompressed 24-bit and 32-bit (BI_RGB / BI_BITFIELDS) images
+ * with BITMAPINFOHEADER, BITMAPV4HEADER or BITMAPV5HEADER, bottom-up or
+ * top-down. Data is embedded in the colour bytes of the pixel array, which
+ * starts at bfOffBits and spans row_size * height bytes. Carrier offsets number
+ * the colour bytes from bfOffBits on, row after row, leaving out the row padding
+ * and the alpha byte of 32-bit pixels : a 24-bit image without padding has
+ * carrier offsets equal to file offsets. Images from before stego version 3
+ * and piped ones use every byte of the pixel array instead
+ */
+
+/* BITMAPFILEHEADER */
+#define BMP_FILE_HEADER_SIZE 14
+
+/* Smallest supported info header (BITMAPINFOHEADER) */
+#define BMP_INFO_HEADER_SIZE 40
+
+/* Largest bfOffBits accepted, everything before the pixels is kept in memory */
+#define BMP_MAX_HEADER_SIZE 4096
+
+typedef struct
+{
+    uint pixel_offset;      /* bfOffBits : start of the pixel array */
+    uint info_size;         /* biSize : 40, 108 (V4) or 124 (V5) */
+    int width;
+    int height;             /* rows, always positive */
+    int bpp;                /* bits per pixel, 24 or 32 */
+    long row_size;          /* bytes per row, padded to 4 bytes */
+    long pixel_span;        /* row_size * height : the whole pixel array */
+    long carriers;          /* width * 3 * height : colour bytes, the ones that carry data */
+    const char *error;      /* why the header was rejected */
+} BmpInfo;
+
+/*
+ * Parse the first size bytes of a BMP file, at least BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_SIZE
+ * Return Value: e_success, or e_failure with info->error set
+ */
+Status bmp_parse_header(const char *header, size_t size, BmpInfo *info);
+
+/* Non zero when the pixel array holds more than the colour bytes : row padding or alpha */
+int bmp_has_gaps(const BmpInfo *info);
+
+/* End of the carrier offsets whose colour bytes lie in the first size bytes of the file */
+long bmp_carrier_end(const BmpInfo *info, long size);
+
+/* Copy the n colour bytes at carrier offset pos out of map into buf */
+void bmp_gather(const BmpInfo *info, const char *map, long pos, long n, char *buf);
+
+/* Copy n bytes of buf back to the colour bytes at carrier offset pos of map */
+void bmp_put(const BmpInfo *info, char *map, long pos, long n, const char *buf);
+
+#endif
@@ -1,7 +1,132 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <stdio.h>
+#include "types.h"
+
 /* Magic string to identify whether stegged or not */
 #define MAGIC_STRING "#*"
 
+/*
+ * Stego header, stored right after MAGIC_STRING at 1 LSB per byte :
+ * version byte, LSB depth byte, flags byte. Every field after it uses the depth.
+ * Images from before the header have a 0 where the version goes
+ * (the high byte of the extension size) and are decoded at depth 1
+ * Version 2 stores the secret file size in 8 bytes, version 1 and
+ * images without the header in 4. Version 3 embeds in the colour bytes
+ * only, leaving row padding and alpha alone (bmp.h), everything before it
+ * in every byte of the pixel array, as piped covers still are
+ */
+#define STEGO_VERSION 3
+#define STEGO_VERSION_CONTIGUOUS 2
+#define STEGO_HEADER_SIZE 3
+
+/* Bytes of the secret file size field for a header version */
+#define STEGO_SIZE_BYTES(version) ((version) >= 2 ? 8 : 4)
+#define STEGO_MAX_SIZE_BYTES 8
+
+/*
+ * Stego header flags (third header byte)
+ * STEGO_FLAG_FRAMED : length of the secret wasn't known up front (stdin),
+ * the file size field is 0 and the data is a series of frames, each a
+ * 4 byte big endian length followed by that many bytes, ended by a 0 length
+ */
+#define STEGO_FLAG_FRAMED 0x01
+
+/*
+ * STEGO_FLAG_DEFLATE : the secret was compressed with zlib (--compress),
+ * the frames carry the zlib stream, always set together with STEGO_FLAG_FRAMED
+ */
+#define STEGO_FLAG_DEFLATE 0x02
+
+/*
+ * STEGO_FLAG_CONTAINER : the secret holds several files behind a table of
+ * contents (--add), see container.h. The extension is empty
+ */
+#define STEGO_FLAG_CONTAINER 0x04
+
+/*
+ * STEGO_FLAG_CRC : the secret data is followed by the CRC-32C of the secret
+ * (before compression), 4 bytes big endian at the depth. It is built while the
+ * data is embedded, which is why it trails the data instead of sitting in the header.
+ * Container payloads carry a checksum per file instead
+ */
+#define STEGO_FLAG_CRC 0x08
+
+/* Bytes of the STEGO_FLAG_CRC trailer */
+#define STEGO_CRC_SIZE 4
+
+/*
+ * STEGO_FLAG_ENCRYPTED : the secret is sealed with a passphrase (--passphrase),
+ * a crypto header follows the secret file size field and the data is a series
+ * of authenticated records, see aead.h. The size field holds the embedded size,
+ * records and tags included. Framed secrets store one record per frame, ended
+ * by an empty last record. The records authenticate the data, so there is no
+ * STEGO_FLAG_CRC trailer
+ */
+#define STEGO_FLAG_ENCRYPTED 0x10
+
+/*
+ * STEGO_FLAG_SCATTER : everything after the secret file size field is spread
+ * over the pixel array in a key-seeded order (--scatter), see scatter.h
+ */
+#define STEGO_FLAG_SCATTER 0x20
+
+/*
+ * STEGO_FLAG_FEC : everything after the stego header is protected by interleaved
+ * Reed-Solomon codes (--fec N), see fec.h. The magic string and stego header are
+ * stored STEGO_FEC_COPIES times, then a FEC header holding N, and the data parts
+ * of the blocks carry the rest of the stego stream ahead of their CRC-32C
+ */
+#define STEGO_FLAG_FEC 0x40
+
+/* Bytes of the STEGO_FLAG_FEC header, copies of the parity count */
+#define STEGO_FEC_HEADER_SIZE 3
+
+/* Copies of the magic string and stego header in FEC images, the bytes of one, and the bits two of them may differ in */
+#define STEGO_FEC_COPIES 3
+#define STEGO_PREAMBLE_SIZE (sizeof(MAGIC_STRING) - 1 + STEGO_HEADER_SIZE)
+#define STEGO_FEC_COPY_DIST 8
+
+#define STEGO_KNOWN_FLAGS (STEGO_FLAG_FRAMED | STEGO_FLAG_DEFLATE | STEGO_FLAG_CONTAINER | STEGO_FLAG_CRC | \
+                           STEGO_FLAG_ENCRYPTED | STEGO_FLAG_SCATTER | STEGO_FLAG_FEC)
+
+/* zlib level for --compress (override with -DSTEGO_ZLIB_LEVEL=...), text gains little past level 1 */
+#ifndef STEGO_ZLIB_LEVEL
+#define STEGO_ZLIB_LEVEL 1
+#endif
+
+/* Size of the BMP file header plus BITMAPINFOHEADER */
+#define BMP_HEADER_SIZE 54
+
+/* File name standing for stdin / stdout */
+#define STDIO_FNAME "-"
+
+/* Non zero silences the per-stage INFO progress messages, errors are still printed */
+extern int stego_quiet;
+
+/* printf for progress messages, honours stego_quiet */
+#define INFO_PRINTF(...) do { if (!stego_quiet) printf(__VA_ARGS__); } while (0)
+
+/*
+ * Optional callback run as each stage of do_encoding() / do_decoding() finishes,
+ * with the stage (function) name. NULL when nobody is measuring
+ */
+typedef void (*StageHook)(const char *stage);
+extern StageHook stego_stage_hook;
+
+#define STAGE_DONE(stage) do { if (stego_stage_hook) stego_stage_hook(stage); } while (0)
+
+/*
+ * fopen() that maps STDIO_FNAME to stdin (read modes) or stdout (write modes)
+ * Once stdout carries data, progress messages are moved over to stderr
+ */
+FILE *stego_fopen(const char *fname, const char *mode);
+
+/* Keep stdout for data, from here on printf() goes to stderr */
+Status stego_claim_stdout(void);
+
+/* Non zero if fname is STDIO_FNAME */
+int is_stdio_fname(const char *fname);
+
 #endif
@@ -0,0 +1,234 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "container.h"
+#include "crc32c.h"
+#include "lsb.h"
+
+/* Bytes of one table entry */
+#define CONTAINER_ENTRY_SIZE(name_len) (1 + (name_len) + 8 + 8 + 4)
+
+#define CONTAINER_PAD(size) (((size) + LSB_ALIGN - 1) / LSB_ALIGN * LSB_ALIGN)
+
+static void put_be(char *p, unsigned long long value, int bytes)
+{
+    int i;
+
+    for (i = bytes - 1; i >= 0; i--, value >>= 8)
+        p[i] = value & 0xFF;
+}
+
+static unsigned long long get_be(const char *p, int bytes)
+{
+    unsigned long long value = 0;
+    int i;
+
+    for (i = 0; i < bytes; i++)
+        value = (value << 8) | (unsigned char)p[i];
+    return value;
+}
+
+// Checksum a whole file
+static Status checksum_file(const char *path, long size, uint *crc)
+{
+    char *buffer;
+    FILE *fptr;
+    size_t n;
+    long total = 0;
+
+    fptr = fopen(path, "r");
+    buffer = malloc(1 << 20);
+    if (fptr == NULL || buffer == NULL)
+    {
+        if (fptr != NULL)
+            fclose(fptr);
+        free(buffer);
+        return e_failure;
+    }
+
+    *crc = 0;
+    while ((n = fread(buffer, 1, 1 << 20, fptr)) > 0)
+    {
+        *crc = crc32c(*crc, buffer, n);
+        total += n;
+    }
+
+    free(buffer);
+    fclose(fptr);
+    return total == size ? e_success : e_failure;
+}
+
+Status container_build(Container *container, char **paths, int count)
+{
+    ContainerEntry *entry;
+    struct stat st;
+    long offset;
+    int i, j;
+
+    container->count = count;
+    container->entries = calloc(count, sizeof(ContainerEntry));
+    if (container->entries == NULL)
+        return e_failure;
+
+    container->toc_size = CONTAINER_TOC_HEAD;
+    for (i = 0; i < count; i++)
+    {
+        const char *name = strrchr(paths[i], '/') ? strrchr(paths[i], '/') + 1 : paths[i];
+
+        entry = &container->entries[i];
+        if (*name == '\0' || strlen(name) > CONTAINER_MAX_NAME)
+        {
+            printf("ERROR ❌ : %s : container file names must be 1 to %d characters\n", paths[i], CONTAINER_MAX_NAME);
+            return e_failure;
+        }
+        for (j = 0; j < i; j++)
+        {
+            if (strcmp(container->entries[j].name, name) == 0)
+            {
+                printf("ERROR ❌ : %s : a file called %s is already in the container\n", paths[i], name);
+                return e_failure;
+            }
+        }
+
+        if (stat(paths[i], &st) != 0 || !S_ISREG(st.st_mode))
+        {
+            perror("stat ");
+            printf("ERROR ❌ : %s isn't a regular file\n", paths[i]);
+            return e_failure;
+        }
+
+        strcpy(entry->name, name);
+        entry->path = paths[i];
+        entry->size = st.st_size;
+        if (checksum_file(paths[i], entry->size, &entry->crc) == e_failure)
+        {
+            printf("ERROR ❌ : Unable to read %s\n", paths[i]);
+            return e_failure;
+        }
+        container->toc_size += CONTAINER_ENTRY_SIZE(strlen(name));
+    }
+
+    // Files follow the padded table, each one padded as well
+    container->toc_size = CONTAINER_PAD(container->toc_size);
+    offset = container->toc_size;
+    for (i = 0; i < count; i++)
+    {
+        container->entries[i].offset = offset;
+        offset += CONTAINER_PAD(container->entries[i].size);
+    }
+    container->payload_size = offset;
+
+    return e_success;
+}
+
+void container_write_toc(const Container *container, char *toc)
+{
+    char *p = toc + CONTAINER_TOC_HEAD;
+    int i;
+
+    memset(toc, 0, container->toc_size);
+    put_be(toc, container->toc_size, 4);
+    put_be(toc + 4, container->count, 4);
+
+    for (i = 0; i < container->count; i++)
+    {
+        const ContainerEntry *entry = &container->entries[i];
+        size_t len = strlen(entry->name);
+
+        *p++ = len;
+        memcpy(p, entry->name, len);
+        p += len;
+        put_be(p, entry->offset, 8);
+        put_be(p + 8, entry->size, 8);
+        put_be(p + 16, entry->crc, 4);
+        p += 20;
+    }
+}
+
+long container_toc_size(const char *head, long payload_size)
+{
+    long toc_size = get_be(head, 4);
+
+    if (toc_size < CONTAINER_TOC_HEAD || toc_size % LSB_ALIGN || toc_size > payload_size || toc_size > CONTAINER_MAX_TOC)
+        return -1;
+    return toc_size;
+}
+
+Status container_read_toc(Container *container, const char *toc, long toc_size, long payload_size)
+{
+    const char *p = toc + CONTAINER_TOC_HEAD, *end = toc + toc_size;
+    long next = toc_size;
+    int i;
+
+    container->count = get_be(toc + 4, 4);
+    container->toc_size = toc_size;
+    container->payload_size = payload_size;
+
+    // Every entry takes at least 22 bytes, anything above that count is corrupt
+    if (container->count > (toc_size - CONTAINER_TOC_HEAD) / CONTAINER_ENTRY_SIZE(1))
+        return e_failure;
+
+    container->entries = calloc(container->count ? container->count : 1, sizeof(ContainerEntry));
+    if (container->entries == NULL)
+        return e_failure;
+
+    for (i = 0; i < container->count; i++)
+    {
+        ContainerEntry *entry = &container->entries[i];
+        size_t len;
+
+        if (p >= end)
+            return e_failure;
+        len = (unsigned char)*p++;
+        if (len == 0 || end - p < (long)len + 20)
+            return e_failure;
+        memcpy(entry->name, p, len);
+        entry->name[len] = '\0';
+        p += len;
+
+        // Names come from the image, they must stay inside the output directory
+        if (strlen(entry->name) != len || strchr(entry->name, '/') != NULL ||
+            strcmp(entry->name, ".") == 0 || strcmp(entry->name, "..") == 0)
+            return e_failure;
+
+        entry->offset = get_be(p, 8);
+        entry->size = get_be(p + 8, 8);
+        entry->crc = get_be(p + 16, 4);
+        p += 20;
+
+        // In order, aligned and inside the payload
+        if (entry->offset < next || entry->offset % LSB_ALIGN || entry->size < 0 ||
+            entry->size > payload_size - entry->offset)
+            return e_failure;
+        next = entry->offset + entry->size;
+    }
+
+    return e_success;
+}
+
+ContainerEntry *container_find(Container *container, const char *name)
+{
+    int i;
+
+    for (i = 0; i < container->count; i++)
+    {
+        if (strcmp(container->entries[i].name, name) == 0)
+            return &container->entries[i];
+    }
+    return NULL;
+}
+
+void container_free(Container *container)
+{
+    free(container->entries);
+    container->entries = NULL;
+    container->count = 0;
+}
@@ -0,0 +1,71 @@
+#ifndef CONTAINER_H
+#define CONTAINER_H
+
+#include "types.h"
+
+/*
+ * Multi-file container payload (STEGO_FLAG_CONTAINER)
+ * The payload starts with a table of contents, then the files follow
+ * in order. All integers are big endian :
+ *
+ *   toc size (4) | entry count (4) | reserved (4)
+ *   per entry : name length (1) | name | offset (8) | size (8) | crc32c (4)
+ *
+ * The table and every file are zero padded to a multiple of LSB_ALIGN
+ * bytes, so each one starts on a whole stego byte at any depth and a
+ * single file can be extracted by seeking straight to it. Offsets are
+ * from the start of the payload
+ */
+
+/* Longest file name stored for an entry */
+#define CONTAINER_MAX_NAME 255
+
+/* Fixed part in front of the entries, one LSB_ALIGN unit */
+#define CONTAINER_TOC_HEAD 12
+
+/* Largest table accepted when decoding */
+#define CONTAINER_MAX_TOC (16 << 20)
+
+typedef struct
+{
+    char name[CONTAINER_MAX_NAME + 1];
+
+    /* File read when encoding */
+    const char *path;
+
+    long offset;
+    long size;
+    uint crc;
+} ContainerEntry;
+
+typedef struct
+{
+    int count;
+    ContainerEntry *entries;
+
+    /* Padded size of the table of contents */
+    long toc_size;
+
+    /* Table plus all padded files, the size stored in the stego image */
+    long payload_size;
+} Container;
+
+/* Lay out paths (stored under their base names) and checksum them, reads every file once */
+Status container_build(Container *container, char **paths, int count);
+
+/* Write the table of contents into toc, container->toc_size bytes */
+void container_write_toc(const Container *container, char *toc);
+
+/* Table size from the first CONTAINER_TOC_HEAD bytes of a payload, -1 if they aren't a table */
+long container_toc_size(const char *head, long payload_size);
+
+/* Read a table of contents of toc_size bytes, checking that every entry lies inside the payload */
+Status container_read_toc(Container *container, const char *toc, long toc_size, long payload_size);
+
+/* Entry called name, NULL if there is none */
+ContainerEntry *container_find(Container *container, const char *name);
+
+/* Release the entries */
+void container_free(Container *container);
+
+#endif
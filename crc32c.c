@@ -0,0 +1,154 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project
+*/
+
+#include <string.h>
+#include <pthread.h>
+#include "crc32c.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CRC32C_X86 1
+#include <immintrin.h>
+#endif
+
+/* Reflected Castagnoli polynomial */
+#define CRC32C_POLY 0x82F63B78u
+
+static uint crc32c_table[256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+static void crc32c_init(void)
+{
+    uint i, crc;
+    int j;
+
+    for (i = 0; i < 256; i++)
+    {
+        crc = i;
+        for (j = 0; j < 8; j++)
+            crc = (crc >> 1) ^ (CRC32C_POLY & (0u - (crc & 1)));
+        crc32c_table[i] = crc;
+    }
+}
+
+// Table driven, one byte per step
+static uint crc32c_table_update(uint crc, const unsigned char *p, size_t size)
+{
+    pthread_once(&crc32c_once, crc32c_init);
+
+    while (size--)
+        crc = (crc >> 8) ^ crc32c_table[(crc ^ *p++) & 0xFF];
+    return crc;
+}
+
+#ifdef CRC32C_X86
+
+// SSE4.2 crc32 instruction, 8 bytes per step
+__attribute__((target("sse4.2")))
+static uint crc32c_sse42_update(uint crc, const unsigned char *p, size_t size)
+{
+    unsigned long long crc64 = crc, word;
+
+    // Byte steps up to an 8 byte boundary
+    for (; size > 0 && ((size_t)p & 7); size--)
+        crc64 = _mm_crc32_u8(crc64, *p++);
+
+    // Four independent loads per iteration keep the loads ahead of the crc32 latency
+    for (; size >= 32; size -= 32, p += 32)
+    {
+        memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        memcpy(&word, p + 8, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        memcpy(&word, p + 16, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        memcpy(&word, p + 24, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+
+    for (; size >= 8; size -= 8, p += 8)
+    {
+        memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+
+    while (size--)
+        crc64 = _mm_crc32_u8(crc64, *p++);
+
+    return crc64;
+}
+
+#endif
+
+// Checksum with the crc32 instruction when the CPU has it, else the table
+uint crc32c(uint crc, const void *data, size_t size)
+{
+    crc = ~crc;
+#ifdef CRC32C_X86
+    if (__builtin_cpu_supports("sse4.2"))
+        return ~crc32c_sse42_update(crc, data, size);
+#endif
+    return ~crc32c_table_update(crc, data, size);
+}
+
+// Multiply a vector over GF(2) by a 32x32 bit matrix
+static uint gf2_matrix_times(const uint *mat, uint vec)
+{
+    uint sum = 0;
+
+    for (; vec; vec >>= 1, mat++)
+    {
+        if (vec & 1)
+            sum ^= *mat;
+    }
+    return sum;
+}
+
+static void gf2_matrix_square(uint *square, const uint *mat)
+{
+    int n;
+
+    for (n = 0; n < 32; n++)
+        square[n] = gf2_matrix_times(mat, mat[n]);
+}
+
+// Same method as zlib's crc32_combine() : apply len2 zero bytes to crc1 by
+// repeated squaring of the one zero bit operator, then add crc2
+uint crc32c_combine(uint crc1, uint crc2, long len2)
+{
+    uint even[32], odd[32], row;
+    int n;
+
+    if (len2 <= 0)
+        return crc1;
+
+    // Operator for one zero bit
+    odd[0] = CRC32C_POLY;
+    for (n = 1, row = 1; n < 32; n++, row <<= 1)
+        odd[n] = row;
+
+    // Two zero bits, then four
+    gf2_matrix_square(even, odd);
+    gf2_matrix_square(odd, even);
+
+    // First squaring gives one zero byte, every later one doubles it
+    do
+    {
+        gf2_matrix_square(even, odd);
+        if (len2 & 1)
+            crc1 = gf2_matrix_times(even, crc1);
+        len2 >>= 1;
+        if (len2 == 0)
+            break;
+
+        gf2_matrix_square(odd, even);
+        if (len2 & 1)
+            crc1 = gf2_matrix_times(odd, crc1);
+        len2 >>= 1;
+    } while (len2 != 0);
+
+    return crc1 ^ crc2;
+}
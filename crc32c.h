@@ -0,0 +1,21 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stddef.h>
+#include "types.h"
+
+/*
+ * CRC-32C (Castagnoli), the checksum of iSCSI / ext4 / SSE4.2 crc32
+ * crc32c(0, data, size) checksums a buffer, passing the previous result
+ * as crc continues it over the next piece. Uses the SSE4.2 crc32
+ * instruction when the CPU has it
+ */
+uint crc32c(uint crc, const void *data, size_t size);
+
+/*
+ * Checksum of A followed by B from crc1 = crc32c(0, A), crc2 = crc32c(0, B)
+ * and the length of B, lets stripes checksum their pieces independently
+ */
+uint crc32c_combine(uint crc1, uint crc2, long len2);
+
+#endif
@@ -2,16 +2,34 @@
 #define DECODE_H
 
 #include "types.h"
+#include "lsb.h"
+#include "common.h"
+#include "bmp.h"
+#include "aead.h"
+#include "scatter.h"
+#include "fec.h"
 
 #define MAX_SECRET_BUF_SIZE 1
 #define MAX_IMAGE_BUF_SIZE (MAX_SECRET_BUF_SIZE * 8)
 #define MAX_FILE_SUFFIX 4
 
+/* Stego bytes read and extracted per block (override with -DDEC_BLOCK_SIZE=...) */
+#ifndef DEC_BLOCK_SIZE
+#define DEC_BLOCK_SIZE (1 << 20)
+#endif
+
+/* Secret bytes extracted per block, a multiple of LSB_ALIGN that fits a stego block at any depth */
+#define DEC_CHUNK_SIZE (DEC_BLOCK_SIZE / 8 / LSB_ALIGN * LSB_ALIGN)
+
+/* Sealed records extracted per block, whole records only (--passphrase) */
+#define DEC_SEALED_CHUNK (DEC_CHUNK_SIZE / AEAD_RECORD * AEAD_RECORD)
+
 typedef struct _DecodeInfo
 {
     /* Source Image info */
     char *stego_image_fname;
     FILE *fptr_stego_image;
+    BmpInfo bmp;
     
 
     //char image_data[MAX_IMAGE_BUF_SIZE];
@@ -24,6 +42,66 @@ typedef struct _DecodeInfo
     long int size_secret_file;
     int extn_size;
 
+    /* Memory mapped mode (--mmap) */
+    int use_mmap;
+    char *stego_map;
+    long image_size;
+    long map_pos;
+
+    /* Threads extracting the secret data (-j N) */
+    int threads;
+
+    /* LSBs used per stego byte after the stego header, read from the header */
+    int depth;
+
+    /* Stego header version, 0 for images from before the header */
+    int version;
+
+    /* STEGO_FLAG_* bits read from the stego header */
+    int flags;
+
+    /* Image has no stego header, the byte read in its place starts the extension size */
+    int legacy;
+
+    /* FEC images : stego header outvoted from its copies by decode_magic_string() */
+    unsigned char stego_header[STEGO_HEADER_SIZE];
+    int header_voted;
+
+    /* --range : only secret bytes [range_offset, range_offset + range_size), range_size -1 for all */
+    long range_offset;
+    long range_size;
+
+    /* Container images : only list the files (--list) or only extract one (--entry NAME) */
+    int list;
+    const char *entry;
+
+    /* --verify : decode and check the checksums without writing anything */
+    int verify;
+
+    /* CRC-32C of the decoded secret data, compared with the STEGO_FLAG_CRC trailer */
+    uint crc;
+
+    /* --passphrase : key for STEGO_FLAG_ENCRYPTED images, from the crypto header */
+    const char *passphrase;
+    AeadKey key;
+
+    /* Secret bytes the sealed records open to, size_secret_file is what is embedded */
+    long plain_size;
+
+    /* --scatter : key phrase for STEGO_FLAG_SCATTER images, and the permutation once the scattered region starts */
+    const char *scatter_key;
+    Scatter scatter;
+
+    /* STEGO_FLAG_FEC images : the blocks read from the FEC header, and the repairs made so far */
+    Fec fec;
+    FecStats fec_stats;
+
+    /* map_pos is a carrier offset, or a virtual offset into the scattered cells or the FEC blocks */
+    Remap remapped;
+
+    /* Reusable stego block of decode_data_from_image(), DEC_BLOCK_SIZE bytes once allocated */
+    char *arena;
+
 } DecodeInfo;
 
 
@@ -35,14 +113,24 @@ Status do_decoding(DecodeInfo *decInfo);
 
 Status decode_magic_string(FILE *fptr_stego_image, DecodeInfo *decInfo);
 
+Status decode_stego_header(DecodeInfo *decInfo);
+
 Status decode_secret_file_extn_size(DecodeInfo *decInfo);
 
 Status decode_secret_file_extn(DecodeInfo *decInfo);
 
 Status decode_secret_file_size(DecodeInfo *decInfo);
 
+Status decode_scatter_region(DecodeInfo *decInfo);
+
+Status decode_fec_header(DecodeInfo *decInfo);
+
+Status decode_crypt_header(DecodeInfo *decInfo);
+
 Status secret_file_data(DecodeInfo *decInfo);
 
+Status decode_data_from_image(char *data, long size, int depth, DecodeInfo *decInfo);
+
 Status decode_byte_from_lsb(char *buffer, char *image_buffer);
 
 int decode_int_from_lsb(const char *buffer);
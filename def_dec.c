@@ -9,20 +9,62 @@ Description :Steganography Project
 #include <string.h>
 #include "types.h"
 #include "common.h"
+#include "lsb.h"
+#include "parallel.h"
 #include <stdlib.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <zlib.h>
+#include "container.h"
+#include "crc32c.h"
+#include "aead.h"
+#include "scatter.h"
+#include "fec.h"
+
+#if DEC_CHUNK_SIZE < AEAD_RECORD
+#error "DEC_BLOCK_SIZE is too small to hold a sealed record"
+#endif
 
 // Function to validate decoding command line arguments
 Status read_and_validate_decode_args(char *argv[], DecodeInfo *decInfo)
 {
-    printf("INFO ℹ️  : Validating arguments\n");
+    // Secret to stdout, keep progress messages out of it
+    if (argv[3] != NULL && is_stdio_fname(argv[3]) && stego_claim_stdout() == e_failure)
+        return e_failure;
+
+    INFO_PRINTF("INFO ℹ️  : Validating arguments\n");
     decInfo->fptr_stego_image = NULL;
     decInfo->fptr_secret = NULL;
+    decInfo->stego_map = NULL;
+    decInfo->use_mmap = 0;
+    decInfo->threads = 1;
+    decInfo->depth = 1;
+    decInfo->flags = 0;
+    decInfo->legacy = 0;
+    decInfo->header_voted = 0;
+    decInfo->version = 0;
+    decInfo->range_offset = 0;
+    decInfo->range_size = -1;
+    decInfo->list = 0;
+    decInfo->entry = NULL;
+    decInfo->verify = 0;
+    decInfo->crc = 0;
+    decInfo->passphrase = NULL;
+    decInfo->plain_size = 0;
+    decInfo->scatter_key = NULL;
+    decInfo->fec_stats.fixed = 0;
+    decInfo->fec_stats.failed = 0;
+    decInfo->remapped = e_remap_none;
+    decInfo->arena = NULL;
 
-    // Validate input image extension
+    // Validate input image extension ("-" reads it from stdin)
     char *ch = strrchr(argv[2], '.');
-    if(ch != NULL && strcmp(ch, ".bmp") == 0)
+    if(is_stdio_fname(argv[2]) || (ch != NULL && strcmp(ch, ".bmp") == 0))
     {
-        printf("INFO ✅ : .bmp file validated\n");
+        INFO_PRINTF("INFO ✅ : .bmp file validated\n");
         decInfo->stego_image_fname = argv[2];
     }
     else
@@ -47,15 +89,121 @@ Status read_and_validate_decode_args(char *argv[], DecodeInfo *decInfo)
         strcpy(decInfo->secret_fname, "decode_sec");
     }
 
-    printf("INFO ✅ : Successfully validated all arguments\n\n");
+    INFO_PRINTF("INFO ✅ : Successfully validated all arguments\n\n");
+    return e_success;
+}
+
+// Map the whole stego image read-only, data is extracted straight out of it
+static Status map_stego_image(DecodeInfo *decInfo)
+{
+    struct stat st;
+
+    if (fstat(fileno(decInfo->fptr_stego_image), &st) != 0 || st.st_size < BMP_HEADER_SIZE)
+    {
+        printf("ERROR ❌ : Can't map stego image 📁\n");
+        return e_failure;
+    }
+    decInfo->image_size = st.st_size;
+    decInfo->stego_map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(decInfo->fptr_stego_image), 0);
+    if (decInfo->stego_map == MAP_FAILED)
+    {
+        decInfo->stego_map = NULL;
+        perror("mmap ");
+        printf("ERROR ❌ : Can't map stego image 📁\n");
+        return e_failure;
+    }
+    INFO_PRINTF("INFO ✅ : Mapped .bmp 🗺️\n");
+
+    return e_success;
+}
+
+// End of the pixel array in the mapped image, counted in colour bytes when they are remapped
+// Images before version 3 lay their scattered cells and FEC blocks over the whole pixel array
+static long stego_pixel_end(DecodeInfo *decInfo)
+{
+    long end = decInfo->bmp.pixel_offset + decInfo->bmp.pixel_span;
+
+    if (decInfo->remapped == e_remap_carriers)
+        return bmp_carrier_end(&decInfo->bmp, decInfo->image_size);
+    return end < decInfo->image_size ? end : decInfo->image_size;
+}
+
+// End of the stego bytes map_pos can reach, the last colour byte, whole cell or FEC block once it is remapped
+static long stego_map_end(DecodeInfo *decInfo)
+{
+    switch (decInfo->remapped)
+    {
+        case e_remap_carriers:
+            return stego_pixel_end(decInfo);
+        case e_remap_scatter:
+            return scatter_end(&decInfo->scatter);
+        case e_remap_fec:
+            return fec_end(&decInfo->fec);
+        default:
+            return decInfo->image_size;
+    }
+}
+
+// Whether size bytes at depth fit between map_pos and the end of the stego bytes
+// size comes from the image, so it is compared without multiplying it first
+static int fits_stego_map(DecodeInfo *decInfo, long size, int depth)
+{
+    long end = stego_map_end(decInfo);
+
+    return size >= 0 && decInfo->map_pos <= end && size <= LSB_PAYLOAD_SIZE(end - decInfo->map_pos, depth);
+}
+
+// Copy n stego bytes at offset pos into buf, out of the colour bytes, the scattered cells or the repaired FEC blocks
+static void stego_gather(DecodeInfo *decInfo, long pos, long n, char *buf)
+{
+    if (decInfo->remapped == e_remap_fec)
+        fec_gather(&decInfo->fec, decInfo->stego_map, pos, n, buf, &decInfo->fec_stats);
+    else if (decInfo->remapped == e_remap_scatter)
+        scatter_gather(&decInfo->scatter, decInfo->stego_map, pos, n, buf);
+    else
+        bmp_gather(&decInfo->bmp, decInfo->stego_map, pos, n, buf);
+}
+
+// Map the stego image part way through the headers, for the stages that need every byte at hand
+static Status map_stego_image_late(DecodeInfo *decInfo)
+{
+    off_t pos;
+
+    if (decInfo->use_mmap)
+        return e_success;
+
+    if (is_stdio_fname(decInfo->stego_image_fname))
+    {
+        printf("INFO ❌ : Scattered and FEC images can't be read from stdin 🗺️\n");
+        return e_failure;
+    }
+    if ((pos = ftello(decInfo->fptr_stego_image)) < 0 || map_stego_image(decInfo) == e_failure)
+        return e_failure;
+    decInfo->map_pos = pos;
+    decInfo->use_mmap = 1;
+
     return e_success;
 }
 
 // Function that performs all decoding steps
 Status do_decoding(DecodeInfo *decInfo)
 {
-    printf("INFO 📂 : Opening required files\n");
-    decInfo->fptr_stego_image = fopen(decInfo->stego_image_fname, "r");
+    Status status;
+
+    INFO_PRINTF("INFO 📂 : Opening required files\n");
+
+    // --mmap and -j N need real files
+    if (is_stdio_fname(decInfo->stego_image_fname) || is_stdio_fname(decInfo->secret_fname))
+    {
+        if (decInfo->use_mmap)
+        {
+            fprintf(stderr, "ERROR ❌ : --mmap can't be used with stdin / stdout\n");
+            return e_failure;
+        }
+        decInfo->threads = 1;
+    }
+
+    decInfo->fptr_stego_image = stego_fopen(decInfo->stego_image_fname, "r");
    
     if (decInfo->fptr_stego_image == NULL)
     {
@@ -64,92 +212,309 @@ Status do_decoding(DecodeInfo *decInfo)
         return e_failure; 
     }
 
-    printf("INFO ✅ : Opened .bmp 🖼️\n");
+    INFO_PRINTF("INFO ✅ : Opened .bmp 🖼️\n");
 
-    printf("INFO 🔍 : Decoding Magic String Signature 🔐\n");
+    if (decInfo->use_mmap && map_stego_image(decInfo) == e_failure)
+        return e_failure;
+
+    STAGE_DONE("open_files");
+
+    INFO_PRINTF("INFO 🔍 : Decoding Magic String Signature 🔐\n");
     if(decode_magic_string(decInfo->fptr_stego_image, decInfo) == e_failure)
     {
         printf("INFO ❌ : Can't Decode MAGIC STRING 💢\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("decode_magic_string");
+
+    INFO_PRINTF("INFO 🏷️  : Decoding Stego Header\n");
+    if(decode_stego_header(decInfo) == e_failure)
+    {
+        printf("INFO ❌ : Can't Decode Stego Header 🏷️\n");
+        return e_failure;
+    }
+    INFO_PRINTF("INFO ✅ : Done. %d bit depth\n\n", decInfo->depth);
+    STAGE_DONE("decode_stego_header");
+
+    if (decInfo->flags & STEGO_FLAG_FEC)
+    {
+        INFO_PRINTF("INFO 🩹 : Decoding FEC Header\n");
+        if (decode_fec_header(decInfo) == e_failure)
+        {
+            printf("INFO ❌ : Can't Decode FEC Header 🩹\n");
+            return e_failure;
+        }
+        INFO_PRINTF("INFO ✅ : Done. %d parity bytes per codeword\n\n", decInfo->fec.code.nsym);
+        STAGE_DONE("decode_fec_header");
+    }
 
-    printf("INFO 📐 : Decoding Output File Extenstion Size\n");
+    INFO_PRINTF("INFO 📐 : Decoding Output File Extenstion Size\n");
     if(decode_secret_file_extn_size(decInfo) == e_failure)
     {
         printf("INFO ❌ : Can't Decode Secret File Extenstion Size 🚫\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("decode_secret_file_extn_size");
 
-    printf("INFO 📝 : Decoding secret file Extension\n");
+    INFO_PRINTF("INFO 📝 : Decoding secret file Extension\n");
     if (decode_secret_file_extn(decInfo) == e_failure)
     {
         printf("INFO ❌ : Can't Decode secret file Extension 📄\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("decode_secret_file_extn");
 
-    printf("INFO 📏 : Decoding File Size\n");
+    INFO_PRINTF("INFO 📏 : Decoding File Size\n");
     if(decode_secret_file_size(decInfo) == e_failure)
     {
         printf("INFO ❌ : Can't Decode File Size ❗\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("decode_secret_file_size");
+
+    if (decInfo->flags & STEGO_FLAG_SCATTER)
+    {
+        INFO_PRINTF("INFO 🎲 : Keying the scattered region of the pixel array\n");
+        if (decode_scatter_region(decInfo) == e_failure)
+        {
+            printf("INFO ❌ : Can't set up scattering 🎲\n");
+            return e_failure;
+        }
+        INFO_PRINTF("INFO ✅ : Done\n\n");
+        STAGE_DONE("decode_scatter_region");
+    }
+    else if (decInfo->scatter_key != NULL)
+        INFO_PRINTF("INFO ⚠️  : Image isn't scattered, the --scatter key isn't needed\n");
+
+    if (decInfo->flags & STEGO_FLAG_ENCRYPTED)
+    {
+        INFO_PRINTF("INFO 🔑 : Decoding crypto header and deriving key\n");
+        if (decode_crypt_header(decInfo) == e_failure)
+        {
+            printf("INFO ❌ : Can't set up decryption 🔑\n");
+            return e_failure;
+        }
+        INFO_PRINTF("INFO ✅ : Done\n\n");
+        STAGE_DONE("decode_crypt_header");
+    }
+    else if (decInfo->passphrase != NULL)
+        INFO_PRINTF("INFO ⚠️  : Image isn't encrypted, the passphrase isn't needed\n");
     
-    printf("INFO 💾 : Decoding File Data\n");
-    if(secret_file_data(decInfo) == e_failure)
+    INFO_PRINTF("INFO 💾 : Decoding File Data\n");
+    status = secret_file_data(decInfo);
+
+    // Repairs are reported either way, a failed checksum is explained by damage past repair
+    if (decInfo->fec_stats.fixed > 0)
+        INFO_PRINTF("INFO 🩹 : FEC repaired %ld damaged bytes\n", decInfo->fec_stats.fixed);
+    if (decInfo->fec_stats.failed > 0)
+        printf("INFO ⚠️  : Some FEC codewords were too damaged to repair 🩹\n");
+
+    if (status == e_failure)
     {
         printf("INFO ❌ : Can't Decode File Data 📉\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("secret_file_data");
+
+    return e_success;
+}
+
+// FEC images start with STEGO_FEC_COPIES copies of the magic string and stego header : read that many
+// ahead and take the bitwise vote when they are copies of a header with STEGO_FLAG_FEC, otherwise go back for the plain read
+// stdin can't go back, its images are read as they come
+static Status decode_voted_preamble(DecodeInfo *decInfo)
+{
+    unsigned char copies[STEGO_FEC_COPIES * STEGO_PREAMBLE_SIZE], vote[STEGO_PREAMBLE_SIZE];
+    long map_pos = decInfo->map_pos;
+    off_t pos = 0;
+    int outvoted;
+
+    decInfo->header_voted = 0;
+    if (!decInfo->use_mmap && (pos = ftello(decInfo->fptr_stego_image)) < 0)
+        return e_success;
+
+    if (decode_data_from_image((char *)copies, sizeof(copies), 1, decInfo) == e_success &&
+        (outvoted = fec_vote(copies, STEGO_PREAMBLE_SIZE, STEGO_FEC_COPY_DIST, vote)) >= 0 &&
+        memcmp(vote, MAGIC_STRING, strlen(MAGIC_STRING)) == 0 && (vote[strlen(MAGIC_STRING) + 2] & STEGO_FLAG_FEC))
+    {
+        memcpy(decInfo->stego_header, vote + strlen(MAGIC_STRING), STEGO_HEADER_SIZE);
+        decInfo->header_voted = 1;
+        decInfo->fec_stats.fixed += outvoted;
+        return e_success;
+    }
+
+    decInfo->map_pos = map_pos;
+    if (!decInfo->use_mmap && fseeko(decInfo->fptr_stego_image, pos, SEEK_SET) != 0)
+        return e_failure;
+    return e_success;
+}
+
+// Read the magic string, or the voted copies of it, where map_pos or the stream stands
+static Status decode_magic(DecodeInfo *decInfo)
+{
+    char magic_string[strlen(MAGIC_STRING) + 1];
+
+    if (decode_voted_preamble(decInfo) == e_failure)
+        return e_failure;
+    if (decInfo->header_voted)
+        return e_success;
+
+    if (decode_data_from_image(magic_string, strlen(MAGIC_STRING), 1, decInfo) == e_failure)
+    {
+        printf("INFO ❌ : Can't read data at MAGIC STRING 🔐\n");
+        return e_failure;
+    }
+    magic_string[strlen(MAGIC_STRING)] = '\0';
+
+    return strcmp(magic_string, MAGIC_STRING) == 0 ? e_success : e_failure;
+}
+
+// Look for a version 3 image in the colour bytes of a mapped image with row padding or alpha
+// Anything else goes back to the first pixel byte, older images used every byte of the pixel array
+static Status decode_carrier_magic(DecodeInfo *decInfo)
+{
+    unsigned char version = 0;
+
+    decInfo->remapped = e_remap_carriers;
+    if (decode_magic(decInfo) == e_success)
+    {
+        // Peek at the version, decode_stego_header() reads it again
+        if (decInfo->header_voted)
+            version = decInfo->stego_header[0];
+        else if (decode_data_from_image((char *)&version, 1, 1, decInfo) == e_success)
+            decInfo->map_pos -= LSB_COVER_SIZE(1L, 1);
+        if (version > STEGO_VERSION_CONTIGUOUS)
+            return e_success;
+    }
+
+    decInfo->remapped = e_remap_none;
+    decInfo->map_pos = decInfo->bmp.pixel_offset;
+    decInfo->header_voted = 0;
+    decInfo->fec_stats.fixed = 0;
+    return e_failure;
 }
 
 // Decode the magic string from stego image
 Status decode_magic_string(FILE *fptr_stego_image, DecodeInfo *decInfo)
 {
-    char buffer[8] , ch = 0;
-    int i;
-    char magic_string[strlen(MAGIC_STRING) + 1];
+    char bmp_header[BMP_MAX_HEADER_SIZE];
 
-    fseek(decInfo->fptr_stego_image, 54, SEEK_CUR); // Skip BMP header
-    
-    for (i = 0; i < strlen(MAGIC_STRING); i++)
+    // Parse the BMP headers and skip to the pixels, read rather than seek so stdin works
+    if (decInfo->use_mmap)
     {
-        if(fread(buffer, 8, 1, decInfo->fptr_stego_image) != 1)
+        if (bmp_parse_header(decInfo->stego_map, decInfo->image_size, &decInfo->bmp) == e_failure)
         {
-            printf("INFO ❌ : Can't read data at MAGIC STRING 🔐\n");
+            printf("INFO ❌ : %s 🖼️\n", decInfo->bmp.error);
             return e_failure;
         }
-        if(decode_byte_from_lsb(&ch, buffer) == e_failure)
+        decInfo->map_pos = decInfo->bmp.pixel_offset;
+    }
+    else
+    {
+        if (fread(bmp_header, BMP_HEADER_SIZE, 1, fptr_stego_image) != 1)
+            return e_failure;
+        if (bmp_parse_header(bmp_header, BMP_HEADER_SIZE, &decInfo->bmp) == e_failure)
         {
-            printf("INFO ⚠️ : Can't do byte from lsb operation 🧬\n");
+            printf("INFO ❌ : %s 🖼️\n", decInfo->bmp.error);
             return e_failure;
         }
-       
-        magic_string[i] = ch;
+        if (decInfo->bmp.pixel_offset > BMP_HEADER_SIZE &&
+            fread(bmp_header + BMP_HEADER_SIZE, decInfo->bmp.pixel_offset - BMP_HEADER_SIZE, 1, fptr_stego_image) != 1)
+            return e_failure;
     }
 
-    magic_string[i] = '\0';
+    // Data skips row padding and alpha since version 3, the colour bytes are only at hand in the mapped image
+    if (bmp_has_gaps(&decInfo->bmp) && !is_stdio_fname(decInfo->stego_image_fname))
+    {
+        if (map_stego_image_late(decInfo) == e_failure)
+            return e_failure;
+        if (decode_carrier_magic(decInfo) == e_success)
+            return e_success;
+    }
+
+    if (decode_magic(decInfo) == e_success)
+        return e_success;
+
+    if (bmp_has_gaps(&decInfo->bmp) && is_stdio_fname(decInfo->stego_image_fname))
+        printf("INFO ⚠️  : Version 3 images with row padding or alpha can't be read from stdin 🗺️\n");
+    return e_failure;
+}
+
+// Decode the stego header : version and LSB depth of the following fields
+Status decode_stego_header(DecodeInfo *decInfo)
+{
+    unsigned char header[STEGO_HEADER_SIZE];
+
+    // FEC images had it outvoted from its copies along with the magic string
+    if (decInfo->header_voted)
+        memcpy(header, decInfo->stego_header, STEGO_HEADER_SIZE);
+    else if (decode_data_from_image((char *)header, 1, 1, decInfo) == e_failure)
+        return e_failure;
 
-    if(strcmp(magic_string, MAGIC_STRING) == 0)
+    if (header[0] == 0)
     {
+        // Image from before the stego header, that byte is the first (zero) byte of the extension size
+        decInfo->legacy = 1;
+        decInfo->depth = 1;
+        decInfo->version = 0;
         return e_success;
     }
 
-    return e_failure;
+    // Version 1 only differs in the size of the file size field
+    decInfo->version = header[0];
+    if (header[0] > STEGO_VERSION)
+    {
+        printf("INFO ❌ : Unsupported stego header version %d 🏷️\n", header[0]);
+        return e_failure;
+    }
+
+    // Read from stdin, the colour bytes of a version 3 image with row padding or alpha aren't at hand
+    if (header[0] > STEGO_VERSION_CONTIGUOUS && bmp_has_gaps(&decInfo->bmp) && decInfo->remapped != e_remap_carriers)
+    {
+        printf("INFO ❌ : Version %d images with row padding or alpha can't be read from stdin 🏷️\n", header[0]);
+        return e_failure;
+    }
+
+    if (!decInfo->header_voted && decode_data_from_image((char *)header + 1, STEGO_HEADER_SIZE - 1, 1, decInfo) == e_failure)
+        return e_failure;
+
+    decInfo->depth = header[1];
+    if (decInfo->depth < LSB_MIN_DEPTH || decInfo->depth > LSB_MAX_DEPTH)
+    {
+        printf("INFO ❌ : Invalid LSB depth %d 🏷️\n", decInfo->depth);
+        return e_failure;
+    }
+
+    decInfo->flags = header[2];
+    if (decInfo->flags & ~STEGO_KNOWN_FLAGS)
+    {
+        printf("INFO ❌ : Unsupported stego header flags 0x%02x 🏷️\n", decInfo->flags);
+        return e_failure;
+    }
+
+    return e_success;
 }
 
 // Decode the size of the file extension (stored as int)
 Status decode_secret_file_extn_size(DecodeInfo *decInfo)
 {
-    char buffer[32];
+    unsigned char buffer[4];
 
-    fread(buffer, 32, 1, decInfo->fptr_stego_image);
+    // Legacy images : the first byte was already read by decode_stego_header()
+    buffer[0] = 0;
+    if (decode_data_from_image((char *)buffer + decInfo->legacy, 4 - decInfo->legacy, decInfo->depth, decInfo) == e_failure)
+        return e_failure;
+
+    // Stored big endian, MSB first
+    decInfo->extn_size = (buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
 
-    decInfo->extn_size = decode_int_from_lsb(buffer);
+    if (decInfo->extn_size < 0 || decInfo->extn_size > MAX_FILE_SUFFIX)
+        return e_failure;
 
     return e_success;
 }
@@ -157,31 +522,27 @@ Status decode_secret_file_extn_size(DecodeInfo *decInfo)
 // Decode the file extension from the image
 Status decode_secret_file_extn(DecodeInfo *decInfo)
 {
-    char buffer[8];
-    int i;
     char ch[decInfo->extn_size + 1]; // buffer for extension
 
-    for (i = 0; i < decInfo->extn_size; i++)
+    if (decode_data_from_image(ch, decInfo->extn_size, decInfo->depth, decInfo) == e_failure)
     {
-        fread(buffer, 8, 1, decInfo->fptr_stego_image);
-        if((decode_byte_from_lsb(&ch[i], buffer)) == e_failure)
-        {
-            printf("INFO ⚠️ : Can't do byte from lsb operation 🧬\n");
-            return e_failure;
-        }
+        printf("INFO ⚠️ : Can't do byte from lsb operation 🧬\n");
+        return e_failure;
     }
 
-    ch[i] = '\0';
+    ch[decInfo->extn_size] = '\0';
 
     int f = 1;
 
-    if(strcmp(decInfo->secret_fname, "decode_sec") == 0)
+    if(strcmp(decInfo->secret_fname, "decode_sec") == 0 && !decInfo->verify)
     {
         f = 0;
-        printf("INFO ℹ️  : Output File not mentioned. Creating 'decode_sec%s' as default 📝\n", ch);
+        INFO_PRINTF("INFO ℹ️  : Output File not mentioned. Creating 'decode_sec%s' as default 📝\n", ch);
     }
-        
-    strcat(decInfo->secret_fname, ch);
+
+    // stdout keeps its name
+    if (!is_stdio_fname(decInfo->secret_fname))
+        strcat(decInfo->secret_fname, ch);
 
     return e_success;
 }
@@ -189,81 +550,942 @@ Status decode_secret_file_extn(DecodeInfo *decInfo)
 // Decode size of secret file (in bytes)
 Status decode_secret_file_size(DecodeInfo *decInfo)
 {
-    char buffer[32];
+    unsigned char buffer[STEGO_MAX_SIZE_BYTES];
+    unsigned long long size = 0;
+    int i, n = STEGO_SIZE_BYTES(decInfo->version);
 
-    if(fread(buffer, 32, 1, decInfo->fptr_stego_image) != 1)
+    if(decode_data_from_image((char *)buffer, n, decInfo->depth, decInfo) == e_failure)
     {
         printf("INFO ⚠️ : Can't read data at secret file size 📏\n");
         return e_failure;
     }
 
-    decInfo->size_secret_file = decode_int_from_lsb(buffer);
+    // Big endian, 8 bytes from version 2 on
+    for (i = 0; i < n; i++)
+        size = (size << 8) | buffer[i];
+
+    // Sizes are turned into stego byte counts (size * 8 / depth), keep that product in a long
+    if (size > (unsigned long long)LONG_MAX / 8)
+    {
+        printf("INFO ❌ : Invalid secret file size 📏\n");
+        return e_failure;
+    }
+    decInfo->size_secret_file = size;
 
     return e_success;
 }
 
-// Decode actual data into output file
-Status secret_file_data(DecodeInfo *decInfo)
+// Key the scatter permutation over the colour bytes left after the size field
+// Cells are read in any order, so the image gets mapped here if --mmap wasn't given
+Status decode_scatter_region(DecodeInfo *decInfo)
+{
+    long end;
+
+    if (decInfo->scatter_key == NULL)
+    {
+        printf("INFO ❌ : Image is scattered, give its key with --scatter FILE 🎲\n");
+        return e_failure;
+    }
+
+    if (map_stego_image_late(decInfo) == e_failure)
+        return e_failure;
+
+    end = stego_pixel_end(decInfo);
+    if (scatter_init(&decInfo->scatter, decInfo->scatter_key, decInfo->map_pos, end - decInfo->map_pos,
+                     decInfo->remapped == e_remap_carriers ? &decInfo->bmp : NULL) == e_failure)
+        return e_failure;
+
+    decInfo->remapped = e_remap_scatter;
+    return e_success;
+}
+
+// Read the FEC header and lay the FEC blocks over the rest of the colour bytes
+// Blocks are repaired as a whole, so the image gets mapped here if --mmap wasn't given
+Status decode_fec_header(DecodeInfo *decInfo)
+{
+    unsigned char header[STEGO_FEC_HEADER_SIZE];
+    long end;
+    int nsym;
+
+    if (decInfo->flags & STEGO_FLAG_SCATTER)
+    {
+        printf("INFO ❌ : Image can't be both scattered and FEC protected 🩹\n");
+        return e_failure;
+    }
+
+    if (map_stego_image_late(decInfo) == e_failure ||
+        decode_data_from_image((char *)header, STEGO_FEC_HEADER_SIZE, 1, decInfo) == e_failure)
+        return e_failure;
+
+    // Bitwise majority of the copies, one damaged copy is outvoted
+    nsym = (header[0] & header[1]) | (header[0] & header[2]) | (header[1] & header[2]);
+
+    end = stego_pixel_end(decInfo);
+    if (fec_init(&decInfo->fec, nsym, decInfo->depth, decInfo->map_pos, end - decInfo->map_pos,
+                 decInfo->remapped == e_remap_carriers ? &decInfo->bmp : NULL) == e_failure)
+    {
+        printf("INFO ❌ : Invalid FEC parity count %d 🩹\n", nsym);
+        return e_failure;
+    }
+
+    decInfo->remapped = e_remap_fec;
+    return e_success;
+}
+
+// Read the crypto header and derive the key from the passphrase
+Status decode_crypt_header(DecodeInfo *decInfo)
 {
-    char buffer[8];
-    char ch;
-    int i;
+    char header[AEAD_HEADER_SIZE];
+
+    if (decInfo->passphrase == NULL)
+    {
+        printf("INFO ❌ : Image is encrypted, give its passphrase with --passphrase FILE 🔑\n");
+        return e_failure;
+    }
+
+    if (decode_data_from_image(header, AEAD_HEADER_SIZE, decInfo->depth, decInfo) == e_failure ||
+        aead_load_key(&decInfo->key, decInfo->passphrase, header) == e_failure)
+        return e_failure;
 
-    decInfo->fptr_secret = fopen(decInfo->secret_fname, "w");
-    if(decInfo->fptr_secret == NULL)
+    // Framed secrets have no stored size
+    decInfo->plain_size = 0;
+    if (!(decInfo->flags & STEGO_FLAG_FRAMED) && (decInfo->plain_size = aead_plain_size(decInfo->size_secret_file)) < 0)
     {
-        printf("INFO ❌ : Can't open secret file 📂\n");
+        printf("INFO ❌ : Invalid secret file size for sealed records 📏\n");
         return e_failure;
     }
 
-    for (i = 0; i < decInfo->size_secret_file; i++)
+    return e_success;
+}
+
+/*
+ * Open the sealed records in data, embedded bytes [begin, begin + chunk) with begin a multiple of
+ * AEAD_RECORD, and pack the secret bytes they hold to the front of data. *plain gets how many
+ */
+static Status open_records(DecodeInfo *decInfo, Aead *aead, long begin, long chunk, char *data, long *plain)
+{
+    long index = begin / AEAD_RECORD, n;
+    char *out = data;
+
+    *plain = 0;
+    for (; chunk > 0; index++, data += n + AEAD_TAG_SIZE, chunk -= n + AEAD_TAG_SIZE)
     {
-        if(fread(buffer, 8, 1, decInfo->fptr_stego_image) != 1)
+        n = (chunk < AEAD_RECORD ? chunk : AEAD_RECORD) - AEAD_TAG_SIZE;
+        if (n < 0 || aead_open(aead, index, (index + 1) * AEAD_RECORD >= decInfo->size_secret_file, data, n) == e_failure)
         {
-            printf("INFO ❌ : Can't read secret file data 📥\n");
-            fclose(decInfo->fptr_secret);
+            printf("INFO ❌ : Secret record %ld doesn't authenticate, wrong passphrase or corrupt image 🔑\n", index);
             return e_failure;
         }
 
-        if(decode_byte_from_lsb(&ch, buffer) == e_failure)
-        {
-            printf("INFO ❌ : Can't decode data from secret file data 🔍\n");
-            fclose(decInfo->fptr_secret);
+        memmove(out, data, n);
+        out += n;
+        *plain += n;
+    }
+
+    return e_success;
+}
+
+/* Where the secret data starts in the stego image, shared by all stripes */
+typedef struct
+{
+    DecodeInfo *decInfo;
+    char *out;
+    off_t stego_pos;
+    StripeCrc crc;
+} DecStripeJob;
+
+// Extract secret bytes [begin, end) into the mapped output or with positioned I/O, checksumming them
+// begin is a multiple of LSB_ALIGN (AEAD_RECORD when sealed) so it starts at stego byte LSB_COVER_SIZE(begin, depth)
+// Sealed records are opened in the scratch buffer and their secret bytes go to their own offset
+// --verify has no output : bytes are extracted into the scratch buffer and only checked
+static Status decode_stripe(void *arg, long begin, long end)
+{
+    DecStripeJob *job = arg;
+    DecodeInfo *decInfo = job->decInfo;
+    int depth = decInfo->depth, sealed = decInfo->flags & STEGO_FLAG_ENCRYPTED;
+    char *buffer = NULL, *stego, *data;
+    long chunk, first = begin, plain, out_pos, step = sealed ? DEC_SEALED_CHUNK : DEC_CHUNK_SIZE;
+    uint crc = 0;
+    Aead aead;
+    Status status = e_success;
+
+    // Stego bytes of one block followed by the bytes extracted from it
+    if (job->out == NULL || sealed || decInfo->remapped)
+    {
+        buffer = malloc(DEC_BLOCK_SIZE + DEC_CHUNK_SIZE);
+        if (buffer == NULL)
             return e_failure;
+    }
+    if (sealed && aead_init(&aead, &decInfo->key, 0) == e_failure)
+    {
+        free(buffer);
+        return e_failure;
+    }
+
+    while (begin < end && status == e_success)
+    {
+        chunk = step;
+        if (chunk > end - begin)
+            chunk = end - begin;
+
+        if (decInfo->remapped)
+        {
+            stego_gather(decInfo, job->stego_pos + LSB_COVER_SIZE(begin, depth), LSB_COVER_SIZE(chunk, depth), buffer);
+            stego = buffer;
+        }
+        else if (decInfo->use_mmap)
+            stego = decInfo->stego_map + job->stego_pos + LSB_COVER_SIZE(begin, depth);
+        else if (pread_full(fileno(decInfo->fptr_stego_image), buffer, LSB_COVER_SIZE(chunk, depth), job->stego_pos + LSB_COVER_SIZE(begin, depth)) == e_success)
+            stego = buffer;
+        else
+        {
+            status = e_failure;
+            break;
         }
 
-        if(fwrite(&ch, 1, 1, decInfo->fptr_secret) !=1)
+        data = job->out != NULL && !sealed ? job->out + begin : buffer + DEC_BLOCK_SIZE;
+        lsb_extract(data, chunk, stego, depth);
+
+        plain = chunk;
+        out_pos = begin;
+        if (sealed)
         {
-            printf("INFO ❌ : Can't write secret file data 📝\n");
-            return e_failure;
+            out_pos = begin / AEAD_RECORD * AEAD_CHUNK;
+            if ((status = open_records(decInfo, &aead, begin, chunk, data, &plain)) == e_failure)
+                break;
         }
+        else
+            crc = crc32c(crc, data, chunk);
+
+        // Decoding to stdout runs a single stripe, it writes in order
+        if (job->out != NULL && sealed)
+            memcpy(job->out + out_pos, data, plain);
+        else if (job->out == NULL && !decInfo->verify && is_stdio_fname(decInfo->secret_fname))
+            status = plain == 0 || fwrite(data, plain, 1, decInfo->fptr_secret) == 1 ? e_success : e_failure;
+        else if (job->out == NULL && !decInfo->verify)
+            status = pwrite_full(fileno(decInfo->fptr_secret), data, plain, out_pos);
+        begin += chunk;
     }
 
-    return e_success;
+    stripe_crc_add(&job->crc, first, end, crc);
+    if (sealed)
+        aead_free(&aead);
+    free(buffer);
+    return status;
 }
 
-// Decode a single byte from 8 bytes (1 LSB per byte)
-Status decode_byte_from_lsb(char *ch, char *image_buffer)
+// Decode the secret data from the stream on decInfo->threads threads, one stripe each
+static Status secret_file_data_parallel(DecodeInfo *decInfo)
 {
-    *ch = 0;
-    int get = 0, i, j = 7;
-    for (i = 0; i < 8; i++)
+    DecStripeJob job;
+
+    Status status;
+
+    job.decInfo = decInfo;
+    job.out = NULL;
+    job.stego_pos = ftello(decInfo->fptr_stego_image);
+    if (job.stego_pos < 0 || decInfo->size_secret_file < 0 || stripe_crc_init(&job.crc, decInfo->threads) == e_failure)
+        return e_failure;
+
+    // Sealed stripes start on a record
+    status = run_stripes(decInfo->threads, decInfo->size_secret_file, DEC_CHUNK_SIZE,
+                         decInfo->flags & STEGO_FLAG_ENCRYPTED ? AEAD_RECORD : LSB_ALIGN, decode_stripe, &job);
+    decInfo->crc = stripe_crc_finish(&job.crc);
+    if (status == e_failure)
     {
-        get = image_buffer[i] & 1;
-        get = get << j;
-        *ch = *ch | get;
-        j--;
+        printf("INFO ❌ : Can't read secret file data 📥\n");
+        return e_failure;
     }
 
+    if (fseeko(decInfo->fptr_stego_image, job.stego_pos + LSB_COVER_SIZE(decInfo->size_secret_file, decInfo->depth), SEEK_SET) != 0)
+        return e_failure;
+
     return e_success;
 }
 
-// Decode a 32-bit integer from LSBs of 32 bytes
-int decode_int_from_lsb(const char *buffer)
+// Decode the secret data from the stream one block at a time : read a block of stego
+// bytes, extract it in one pass, checksum it and write the whole chunk out (works on pipes too)
+// Sealed secrets are decrypted and authenticated in the same pass, whole records per block
+static Status secret_file_data_stream(DecodeInfo *decInfo)
 {
-    int size = 0;
-    int get = 0, i, j = 31;
-    for (i = 0; i < 32; i++)
+    long remaining = decInfo->size_secret_file, chunk, plain, pos = 0;
+    int depth = decInfo->depth, sealed = decInfo->flags & STEGO_FLAG_ENCRYPTED;
+    char *buffer, *data;
+    Aead aead;
+    Status status = e_success;
+
+    // Stego bytes of one block followed by the bytes extracted from it
+    buffer = malloc(DEC_BLOCK_SIZE + DEC_CHUNK_SIZE);
+    if (buffer == NULL)
+        return e_failure;
+    if (sealed && aead_init(&aead, &decInfo->key, 0) == e_failure)
+    {
+        free(buffer);
+        return e_failure;
+    }
+    data = buffer + DEC_BLOCK_SIZE;
+
+    while (remaining > 0)
+    {
+        chunk = sealed ? DEC_SEALED_CHUNK : DEC_CHUNK_SIZE;
+        if (chunk > remaining)
+            chunk = remaining;
+
+        if (fread(buffer, LSB_COVER_SIZE(chunk, depth), 1, decInfo->fptr_stego_image) != 1)
+        {
+            printf("INFO ❌ : Can't read secret file data 📥\n");
+            status = e_failure;
+            break;
+        }
+
+        lsb_extract(data, chunk, buffer, depth);
+
+        plain = chunk;
+        if (sealed && (status = open_records(decInfo, &aead, pos, chunk, data, &plain)) == e_failure)
+            break;
+        decInfo->crc = crc32c(decInfo->crc, data, plain);
+
+        if (!decInfo->verify && plain > 0 && fwrite(data, plain, 1, decInfo->fptr_secret) != 1)
+        {
+            printf("INFO ❌ : Can't write secret file data 📝\n");
+            status = e_failure;
+            break;
+        }
+        remaining -= chunk;
+        pos += chunk;
+    }
+
+    if (sealed)
+        aead_free(&aead);
+    free(buffer);
+    return status;
+}
+
+// Move n stego bytes forward, seeking when the stream allows it and reading past them on pipes
+static Status skip_stego_bytes(DecodeInfo *decInfo, long n)
+{
+    char *buffer;
+    long chunk;
+
+    if (decInfo->use_mmap)
+    {
+        decInfo->map_pos += n;
+        return e_success;
+    }
+
+    if (n == 0 || fseeko(decInfo->fptr_stego_image, n, SEEK_CUR) == 0)
+        return e_success;
+
+    buffer = malloc(DEC_BLOCK_SIZE);
+    if (buffer == NULL)
+        return e_failure;
+
+    for (; n > 0; n -= chunk)
+    {
+        chunk = n < DEC_BLOCK_SIZE ? n : DEC_BLOCK_SIZE;
+        if (fread(buffer, chunk, 1, decInfo->fptr_stego_image) != 1)
+            break;
+    }
+
+    free(buffer);
+    return n > 0 ? e_failure : e_success;
+}
+
+/*
+ * Decode secret bytes [offset, offset + size) to fptr, skipping the stego bytes before them unread
+ * *pos is the secret byte the stream stands at (stego byte LSB_COVER_SIZE(*pos, depth) of the data)
+ * and moves to offset + size. Secret bytes at multiples of LSB_ALIGN start on a whole stego byte,
+ * the extraction starts at the last one before offset, which must not be below *pos
+ * crc (if not NULL) gets the CRC-32C of the bytes, fptr NULL only checksums them
+ */
+static Status extract_span(DecodeInfo *decInfo, long *pos, long offset, long size, FILE *fptr, uint *crc)
+{
+    long aligned = offset / LSB_ALIGN * LSB_ALIGN, skip = offset - aligned, chunk, end = offset + size;
+    int depth = decInfo->depth;
+    char *buffer;
+    Status status = e_success;
+
+    if (aligned < *pos || skip_stego_bytes(decInfo, LSB_COVER_SIZE(aligned, depth) - LSB_COVER_SIZE(*pos, depth)) == e_failure)
+    {
+        printf("INFO ❌ : Can't seek to the secret file data 📥\n");
+        return e_failure;
+    }
+
+    buffer = malloc(DEC_CHUNK_SIZE);
+    if (buffer == NULL)
+        return e_failure;
+
+    if (crc != NULL)
+        *crc = 0;
+
+    // The first chunk also carries the skip bytes in front of offset
+    for (size += skip; size > 0; size -= chunk, skip = 0)
+    {
+        chunk = size < DEC_CHUNK_SIZE ? size : DEC_CHUNK_SIZE;
+
+        if (decode_data_from_image(buffer, chunk, depth, decInfo) == e_failure)
+        {
+            printf("INFO ❌ : Can't read secret file data 📥\n");
+            status = e_failure;
+            break;
+        }
+
+        if (fptr != NULL && chunk > skip && fwrite(buffer + skip, chunk - skip, 1, fptr) != 1)
+        {
+            printf("INFO ❌ : Can't write secret file data 📝\n");
+            status = e_failure;
+            break;
+        }
+        if (crc != NULL)
+            *crc = crc32c(*crc, buffer + skip, chunk - skip);
+    }
+
+    free(buffer);
+    *pos = end;
+    return status;
+}
+
+// Decode only secret bytes [range_offset, range_offset + range_size) (--range)
+// Secret byte i sits at a fixed stego offset, so everything before the range is skipped unread
+static Status secret_file_data_range(DecodeInfo *decInfo)
+{
+    long offset = decInfo->range_offset, size = decInfo->range_size, pos = 0;
+
+    if (decInfo->flags & STEGO_FLAG_FRAMED)
+    {
+        printf("INFO ❌ : --range needs a stored secret size, stdin / compressed secrets have none 📐\n");
+        return e_failure;
+    }
+
+    if (offset > decInfo->size_secret_file)
+    {
+        printf("INFO ❌ : --range starts past the end of the %ld byte secret 📐\n", decInfo->size_secret_file);
+        return e_failure;
+    }
+
+    if (size > decInfo->size_secret_file - offset)
+    {
+        size = decInfo->size_secret_file - offset;
+        INFO_PRINTF("INFO ⚠️  : --range cut to the %ld bytes left in the secret\n", size);
+    }
+
+    return extract_span(decInfo, &pos, offset, size, decInfo->fptr_secret, NULL);
+}
+
+/*
+ * Decode a container payload (--add) : read the table of contents, then list it (--list),
+ * or extract every file, or only --entry NAME, into the directory named like the output
+ * (--verify only checks them). Files that aren't wanted are skipped without being read
+ */
+static Status secret_file_data_container(DecodeInfo *decInfo)
+{
+    Container container = { 0 };
+    char head[CONTAINER_TOC_HEAD], *toc, path[PATH_MAX];
+    long toc_size, pos;
+    uint crc;
+    int i, found = 0, to_stdout = is_stdio_fname(decInfo->secret_fname);
+    FILE *fptr;
+    Status status = e_success;
+
+    if (to_stdout && decInfo->entry == NULL && !decInfo->list && !decInfo->verify)
+    {
+        printf("INFO ❌ : Pick one file with --entry NAME to write a container to stdout 📦\n");
+        return e_failure;
+    }
+
+    // The fixed head is one LSB_ALIGN unit, the rest of the table follows it
+    if (decode_data_from_image(head, CONTAINER_TOC_HEAD, decInfo->depth, decInfo) == e_failure ||
+        (toc_size = container_toc_size(head, decInfo->size_secret_file)) < 0 || (toc = malloc(toc_size)) == NULL)
+    {
+        printf("INFO ❌ : Container table of contents is corrupt 📦\n");
+        return e_failure;
+    }
+
+    memcpy(toc, head, CONTAINER_TOC_HEAD);
+    if (decode_data_from_image(toc + CONTAINER_TOC_HEAD, toc_size - CONTAINER_TOC_HEAD, decInfo->depth, decInfo) == e_failure ||
+        container_read_toc(&container, toc, toc_size, decInfo->size_secret_file) == e_failure)
+    {
+        printf("INFO ❌ : Container table of contents is corrupt 📦\n");
+        free(toc);
+        container_free(&container);
+        return e_failure;
+    }
+    free(toc);
+    pos = toc_size;
+
+    if (decInfo->list)
+    {
+        for (i = 0; i < container.count; i++)
+            printf("ENTRY 📄 %s : %ld bytes, crc32c %08x\n", container.entries[i].name, container.entries[i].size, container.entries[i].crc);
+        container_free(&container);
+        return e_success;
+    }
+
+    if (!to_stdout && !decInfo->verify && mkdir(decInfo->secret_fname, 0755) != 0 && errno != EEXIST)
+    {
+        perror("mkdir ");
+        printf("INFO ❌ : Can't create directory %s 📂\n", decInfo->secret_fname);
+        container_free(&container);
+        return e_failure;
+    }
+
+    for (i = 0; i < container.count && status == e_success; i++)
+    {
+        ContainerEntry *entry = &container.entries[i];
+
+        if (decInfo->entry != NULL && strcmp(entry->name, decInfo->entry) != 0)
+            continue;
+        found = 1;
+
+        snprintf(path, sizeof(path), "%s/%s", decInfo->secret_fname, entry->name);
+        if (decInfo->verify)
+            fptr = NULL;
+        else if ((fptr = to_stdout ? stego_fopen(STDIO_FNAME, "w") : fopen(path, "w")) == NULL)
+        {
+            perror("fopen ");
+            printf("INFO ❌ : Can't open %s 📂\n", path);
+            status = e_failure;
+            break;
+        }
+
+        status = extract_span(decInfo, &pos, entry->offset, entry->size, fptr, &crc);
+        if (fptr != NULL && fclose(fptr) != 0)
+            status = e_failure;
+
+        if (status == e_success && crc != entry->crc)
+        {
+            printf("INFO ❌ : %s is corrupt, its checksum doesn't match 📦\n", entry->name);
+            status = e_failure;
+        }
+        if (status == e_success && decInfo->verify)
+            INFO_PRINTF("INFO 🧮 : %s (%ld bytes) checksum OK\n", entry->name, entry->size);
+        else if (status == e_success)
+            INFO_PRINTF("INFO 📄 : Extracted %s (%ld bytes)\n", to_stdout ? entry->name : path, entry->size);
+    }
+
+    if (decInfo->entry != NULL && !found)
+    {
+        printf("INFO ❌ : No file called %s in the container 📦\n", decInfo->entry);
+        status = e_failure;
+    }
+
+    container_free(&container);
+    return status;
+}
+
+// Decode data straight from the mapped stego image into the mapped output file
+static Status secret_file_data_mmap(DecodeInfo *decInfo)
+{
+    DecStripeJob job;
+    long out_size;
+    Status status;
+
+    if (decInfo->size_secret_file == 0)
+        return e_success;
+
+    if (!fits_stego_map(decInfo, decInfo->size_secret_file, decInfo->depth))
+    {
+        printf("INFO ❌ : Secret file size exceeds the stego image 📥\n");
+        return e_failure;
+    }
+
+    job.decInfo = decInfo;
+    job.stego_pos = decInfo->map_pos;
+    job.out = NULL;
+
+    // --verify extracts into the stripes' scratch buffers instead
+    // Sealed records open to plain_size bytes
+    out_size = decInfo->flags & STEGO_FLAG_ENCRYPTED ? decInfo->plain_size : decInfo->size_secret_file;
+
+    // stdout can't be mapped, the stripe writes to it instead
+    if (!decInfo->verify && out_size > 0 && !is_stdio_fname(decInfo->secret_fname))
+    {
+        if (ftruncate(fileno(decInfo->fptr_secret), out_size) != 0)
+        {
+            printf("INFO ❌ : Can't size secret file 📝\n");
+            return e_failure;
+        }
+
+        job.out = mmap(NULL, out_size, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(decInfo->fptr_secret), 0);
+        if (job.out == MAP_FAILED)
+        {
+            printf("INFO ❌ : Can't map secret file 📝\n");
+            return e_failure;
+        }
+    }
+
+    if (stripe_crc_init(&job.crc, decInfo->threads) == e_failure)
+        status = e_failure;
+    else
+    {
+        status = run_stripes(decInfo->threads, decInfo->size_secret_file, DEC_CHUNK_SIZE,
+                             decInfo->flags & STEGO_FLAG_ENCRYPTED ? AEAD_RECORD : LSB_ALIGN, decode_stripe, &job);
+        decInfo->crc = stripe_crc_finish(&job.crc);
+    }
+    decInfo->map_pos += LSB_COVER_SIZE(decInfo->size_secret_file, decInfo->depth);
+
+    if (job.out != NULL)
+        munmap(job.out, out_size);
+    return status;
+}
+
+// Write extracted frame data to the secret file, inflating it first for compressed secrets
+// The checksum covers the data as written, --verify stops short of the write
+static Status write_frame_data(char *data, int size, z_stream *zs, char *zbuf, DecodeInfo *decInfo)
+{
+    size_t n;
+    int ret;
+
+    if (zs == NULL)
+    {
+        decInfo->crc = crc32c(decInfo->crc, data, size);
+        if (!decInfo->verify && fwrite(data, size, 1, decInfo->fptr_secret) != 1)
+            return e_failure;
+        decInfo->size_secret_file += size;
+        return e_success;
+    }
+
+    zs->next_in = (Bytef *)data;
+    zs->avail_in = size;
+    do
+    {
+        zs->next_out = (Bytef *)zbuf;
+        zs->avail_out = DEC_CHUNK_SIZE;
+        ret = inflate(zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+        {
+            printf("INFO ❌ : Compressed secret data is corrupt 🗜️\n");
+            return e_failure;
+        }
+
+        n = DEC_CHUNK_SIZE - zs->avail_out;
+        decInfo->crc = crc32c(decInfo->crc, zbuf, n);
+        if (n > 0 && !decInfo->verify && fwrite(zbuf, n, 1, decInfo->fptr_secret) != 1)
+            return e_failure;
+        decInfo->size_secret_file += n;
+    } while (zs->avail_out == 0);
+
+    return e_success;
+}
+
+// Decode length prefixed frames written for a framed (stdin or compressed) secret, up to the 0 length frame
+static Status secret_file_data_framed(DecodeInfo *decInfo)
+{
+    unsigned char length[4];
+    char *buffer, *zbuf = NULL;
+    unsigned long frame, chunk;
+    long index = 0;
+    int sealed = decInfo->flags & STEGO_FLAG_ENCRYPTED, ended = 0;
+    z_stream zs, *zsp = NULL;
+    Aead aead;
+    Status status = e_success;
+
+    buffer = malloc(DEC_CHUNK_SIZE);
+    if (buffer == NULL)
+        return e_failure;
+    if (sealed && aead_init(&aead, &decInfo->key, 0) == e_failure)
+    {
+        free(buffer);
+        return e_failure;
+    }
+
+    if (decInfo->flags & STEGO_FLAG_DEFLATE)
+    {
+        memset(&zs, 0, sizeof(zs));
+        zbuf = malloc(DEC_CHUNK_SIZE);
+        if (zbuf == NULL || inflateInit(&zs) != Z_OK)
+        {
+            if (sealed)
+                aead_free(&aead);
+            free(zbuf);
+            free(buffer);
+            return e_failure;
+        }
+        zsp = &zs;
+    }
+
+    decInfo->size_secret_file = 0;
+    while (status == e_success)
+    {
+        if (decode_data_from_image((char *)length, 4, decInfo->depth, decInfo) == e_failure)
+        {
+            status = e_failure;
+            break;
+        }
+
+        frame = ((unsigned long)length[0] << 24) | (length[1] << 16) | (length[2] << 8) | length[3];
+        if (frame == 0)
+        {
+            if (sealed && !ended)
+            {
+                printf("INFO ❌ : Sealed secret is cut off before its last record 🔑\n");
+                status = e_failure;
+            }
+            break;
+        }
+
+        // A sealed frame is one whole record, opened before any of it is written
+        if (sealed)
+        {
+            if (ended || frame < AEAD_TAG_SIZE || frame > AEAD_RECORD ||
+                decode_data_from_image(buffer, frame, decInfo->depth, decInfo) == e_failure)
+            {
+                printf("INFO ❌ : Can't read secret file data 📥\n");
+                status = e_failure;
+                break;
+            }
+
+            ended = frame == AEAD_TAG_SIZE;
+            if (aead_open(&aead, index, ended, buffer, frame - AEAD_TAG_SIZE) == e_failure)
+            {
+                printf("INFO ❌ : Secret record %ld doesn't authenticate, wrong passphrase or corrupt image 🔑\n", index);
+                status = e_failure;
+                break;
+            }
+            index++;
+
+            if (frame > AEAD_TAG_SIZE && write_frame_data(buffer, frame - AEAD_TAG_SIZE, zsp, zbuf, decInfo) == e_failure)
+            {
+                printf("INFO ❌ : Can't write secret file data 📝\n");
+                status = e_failure;
+                break;
+            }
+            continue;
+        }
+
+        // Chunks are multiples of LSB_ALIGN, so they line up with the single embed call of the frame
+        while (frame > 0)
+        {
+            chunk = DEC_CHUNK_SIZE;
+            if (chunk > frame)
+                chunk = frame;
+
+            if (decode_data_from_image(buffer, chunk, decInfo->depth, decInfo) == e_failure)
+            {
+                printf("INFO ❌ : Can't read secret file data 📥\n");
+                status = e_failure;
+                break;
+            }
+
+            if (write_frame_data(buffer, chunk, zsp, zbuf, decInfo) == e_failure)
+            {
+                printf("INFO ❌ : Can't write secret file data 📝\n");
+                status = e_failure;
+                break;
+            }
+
+            frame -= chunk;
+        }
+    }
+
+    if (zsp != NULL)
+    {
+        // The zlib stream has to end with the frames
+        if (status == e_success && inflate(zsp, Z_FINISH) != Z_STREAM_END)
+        {
+            printf("INFO ❌ : Compressed secret data is truncated 🗜️\n");
+            status = e_failure;
+        }
+        inflateEnd(zsp);
+        free(zbuf);
+    }
+
+    if (sealed)
+        aead_free(&aead);
+    free(buffer);
+    return status;
+}
+
+// Read the checksum trailer and compare it with the one built while decoding
+static Status check_secret_file_crc(DecodeInfo *decInfo)
+{
+    unsigned char buffer[STEGO_CRC_SIZE];
+    uint stored;
+
+    if (decode_data_from_image((char *)buffer, STEGO_CRC_SIZE, decInfo->depth, decInfo) == e_failure)
+    {
+        printf("INFO ❌ : Can't read the secret checksum, the image is truncated 🧮\n");
+        return e_failure;
+    }
+
+    stored = ((uint)buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
+    if (stored != decInfo->crc)
+    {
+        printf("INFO ❌ : Secret data is corrupt, crc32c %08x doesn't match the stored %08x 🧮\n", decInfo->crc, stored);
+        return e_failure;
+    }
+
+    INFO_PRINTF("INFO 🧮 : Checksum OK, crc32c %08x\n", stored);
+    return e_success;
+}
+
+// Close and remove the secret file, stdout can't take back what it was sent
+static void discard_secret_file(DecodeInfo *decInfo)
+{
+    if (decInfo->fptr_secret == NULL || is_stdio_fname(decInfo->secret_fname))
+        return;
+
+    fclose(decInfo->fptr_secret);
+    decInfo->fptr_secret = NULL;
+    if (unlink(decInfo->secret_fname) != 0)
+        perror("unlink ");
+    else
+        printf("INFO 🗑️  : Removed %s, its data didn't decode intact\n", decInfo->secret_fname);
+}
+
+// Decode actual data into output file, checking it against the checksum trailer on the way
+Status secret_file_data(DecodeInfo *decInfo)
+{
+    Status status;
+
+    if ((decInfo->list || decInfo->entry != NULL) && !(decInfo->flags & STEGO_FLAG_CONTAINER))
+    {
+        printf("INFO ❌ : --list and --entry need an image made with --add 📦\n");
+        return e_failure;
+    }
+
+    // Records are opened whole and in place, there are no fixed secret offsets to seek to
+    if ((decInfo->flags & STEGO_FLAG_ENCRYPTED) && (decInfo->range_size >= 0 || (decInfo->flags & STEGO_FLAG_CONTAINER)))
+    {
+        printf("INFO ❌ : --range and containers aren't supported on encrypted images 🔑\n");
+        return e_failure;
+    }
+
+    // Files of a container go to a directory, --range still reads the raw payload
+    if ((decInfo->flags & STEGO_FLAG_CONTAINER) && decInfo->range_size < 0)
+        return secret_file_data_container(decInfo);
+
+    // A range is only part of what the checksum covers
+    if (decInfo->range_size >= 0)
+    {
+        decInfo->fptr_secret = stego_fopen(decInfo->secret_fname, "w");
+        if (decInfo->fptr_secret == NULL)
+        {
+            printf("INFO ❌ : Can't open secret file 📂\n");
+            return e_failure;
+        }
+        if (secret_file_data_range(decInfo) == e_failure)
+        {
+            discard_secret_file(decInfo);
+            return e_failure;
+        }
+        return e_success;
+    }
+
+    if (!decInfo->verify)
+    {
+        decInfo->fptr_secret = stego_fopen(decInfo->secret_fname, decInfo->use_mmap ? "w+" : "w");
+        if(decInfo->fptr_secret == NULL)
+        {
+            printf("INFO ❌ : Can't open secret file 📂\n");
+            return e_failure;
+        }
+    }
+
+    decInfo->crc = 0;
+    if (decInfo->flags & STEGO_FLAG_FRAMED)
+        status = secret_file_data_framed(decInfo);
+    else if (decInfo->use_mmap)
+        status = secret_file_data_mmap(decInfo);
+    else if (decInfo->threads > 1)
+        status = secret_file_data_parallel(decInfo);
+    else
+        status = secret_file_data_stream(decInfo);
+
+    if (status == e_success && (decInfo->flags & STEGO_FLAG_CRC))
+        status = check_secret_file_crc(decInfo);
+
+    // Data that failed to decode or doesn't match its checksum isn't left behind
+    if (status == e_failure)
+    {
+        discard_secret_file(decInfo);
+        return e_failure;
+    }
+
+    if (decInfo->flags & STEGO_FLAG_ENCRYPTED)
+        INFO_PRINTF("INFO 🔑 : Every secret record authenticated\n");
+    else if (decInfo->verify)
+        printf("INFO ⚠️  : Image was made without a checksum, only its layout could be checked\n");
+    return e_success;
+}
+
+// Decode size bytes of data stored depth bits per image byte, from the stream or the mapping
+Status decode_data_from_image(char *data, long size, int depth, DecodeInfo *decInfo)
+{
+    long chunk;
+    char *buffer = decInfo->arena;
+
+    if (size <= 0)
+        return e_success;
+
+    if (decInfo->use_mmap)
+    {
+        if (!fits_stego_map(decInfo, size, depth))
+            return e_failure;
+
+        // Scattered cells and FEC blocks are gathered block by block below
+        if (!decInfo->remapped)
+        {
+            lsb_extract(data, size, decInfo->stego_map + decInfo->map_pos, depth);
+            decInfo->map_pos += LSB_COVER_SIZE(size, depth);
+            return e_success;
+        }
+    }
+
+    chunk = DEC_CHUNK_SIZE;
+    if (chunk > size)
+        chunk = size;
+
+    // One block serves every call, the headers and each frame would allocate it again otherwise
+    if (buffer == NULL && (buffer = decInfo->arena = malloc(DEC_BLOCK_SIZE)) == NULL)
+    {
+        printf("INFO ❌ : Can't allocate decode buffer 🧠\n");
+        return e_failure;
+    }
+
+    while (size > 0)
+    {
+        if (chunk > size)
+            chunk = size;
+
+        if (decInfo->remapped)
+        {
+            stego_gather(decInfo, decInfo->map_pos, LSB_COVER_SIZE(chunk, depth), buffer);
+            decInfo->map_pos += LSB_COVER_SIZE(chunk, depth);
+        }
+        else if (fread(buffer, LSB_COVER_SIZE(chunk, depth), 1, decInfo->fptr_stego_image) != 1)
+            return e_failure;
+
+        lsb_extract(data, chunk, buffer, depth);
+        data += chunk;
+        size -= chunk;
+    }
+
+    return e_success;
+}
+
+// Decode a single byte from 8 bytes (1 LSB per byte)
+Status decode_byte_from_lsb(char *ch, char *image_buffer)
+{
+    *ch = 0;
+    int get = 0, i, j = 7;
+    for (i = 0; i < 8; i++)
+    {
+        get = image_buffer[i] & 1;
+        get = get << j;
+        *ch = *ch | get;
+        j--;
+    }
+
+    return e_success;
+}
+
+// Decode a 32-bit integer from LSBs of 32 bytes
+int decode_int_from_lsb(const char *buffer)
+{
+    int size = 0;
+    int get = 0, i, j = 31;
+    for (i = 0; i < 32; i++)
     {
         get = buffer[i] & 1;
         get = get << j;
@@ -279,12 +1501,21 @@ Status close_dec_files(DecodeInfo *decInfo)
 {
     int flag = 0;
 
+    if (decInfo->stego_map != NULL)
+    {
+        munmap(decInfo->stego_map, decInfo->image_size);
+        decInfo->stego_map = NULL;
+    }
+
+    free(decInfo->arena);
+    decInfo->arena = NULL;
+
     if (decInfo->fptr_stego_image != NULL)
     {
         flag = 1;
         fclose(decInfo->fptr_stego_image);
         decInfo->fptr_stego_image = NULL;
-        printf("INFO 📁 : Closed %s ✅\n", decInfo->stego_image_fname);
+        INFO_PRINTF("INFO 📁 : Closed %s ✅\n", decInfo->stego_image_fname);
     }
 
     if(decInfo->fptr_secret != NULL)
@@ -292,10 +1523,10 @@ Status close_dec_files(DecodeInfo *decInfo)
         flag = 1;
         fclose(decInfo->fptr_secret);
         decInfo->fptr_secret = NULL;
-        printf("INFO 📄 : Closed %s ✅\n", decInfo->secret_fname);
+        INFO_PRINTF("INFO 📄 : Closed %s ✅\n", decInfo->secret_fname);
     }
 
     if(flag)
-        printf("INFO ✅ : All files closed 🔒\n\n");
+        INFO_PRINTF("INFO ✅ : All files closed 🔒\n\n");
     return e_success;
 }
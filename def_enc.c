@@ -5,12 +5,31 @@ Date        :30/07/2025
 Description :Steganography Project
 */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include "encode.h"
 #include <string.h>
 #include "types.h"
 #include "common.h"
+#include "lsb.h"
+#include "parallel.h"
 #include <stdlib.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "crc32c.h"
+#include "aead.h"
+#include "scatter.h"
+#include "fec.h"
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+#if ENC_CHUNK_SIZE < AEAD_RECORD
+#error "ENC_BLOCK_SIZE is too small to hold a sealed record"
+#endif
 
 //Checking the operation type
 OperationType check_operation_type(char *argv[])
@@ -25,27 +44,62 @@ OperationType check_operation_type(char *argv[])
     {
         return e_decode;
     }
+    else if(strcmp(argv[1], "-b") == 0)
+    {
+        return e_batch;
+    }
+    else if(strcmp(argv[1], "--scan") == 0)
+    {
+        return e_scan;
+    }
     else
     {
-        return e_unsupported; //Other than -e / -d
+        return e_unsupported; //Other than -e / -d / -b / --scan
     }
 }
 
 //Read and validate the arguments
 Status read_and_validate_encode_args(char *argv[], EncodeInfo *encInfo)
 {
-    printf("INFO ℹ️  : Validating arguments\n");
+    // Stego image to stdout, keep progress messages out of it
+    if (argv[4] != NULL && is_stdio_fname(argv[4]) && stego_claim_stdout() == e_failure)
+        return e_failure;
+
+    INFO_PRINTF("INFO ℹ️  : Validating arguments\n");
     // Initialize file pointers
     encInfo->fptr_secret = NULL;
     encInfo->fptr_src_image = NULL;
     encInfo->fptr_stego_image = NULL;
+    encInfo->src_map = NULL;
+    encInfo->secret_map = NULL;
+    encInfo->stego_map = NULL;
+    encInfo->arena = NULL;
+    encInfo->arena_size = 0;
+    encInfo->pipelined = 1;
+    encInfo->use_mmap = 0;
+    encInfo->cloned = 0;
+    encInfo->threads = 1;
+    encInfo->depth = 1;
+    encInfo->flags = 0;
+    encInfo->container_files = NULL;
+    encInfo->container_count = 0;
+    encInfo->container.entries = NULL;
+    encInfo->container.count = 0;
+    encInfo->passphrase = NULL;
+    encInfo->plain_size = 0;
+    encInfo->records = 0;
+    encInfo->scatter_key = NULL;
+    encInfo->fec_parity = 0;
+    encInfo->fec.filled = NULL;
+    encInfo->remapped = e_remap_none;
+    encInfo->version = STEGO_VERSION;
 
-    // Check if source image file has .bmp extension
+    // Check if source image file has .bmp extension ("-" reads it from stdin)
     char *ch = strrchr(argv[2], '.');
-    if(ch != NULL && strcmp(ch, ".bmp") == 0)
+    if(is_stdio_fname(argv[2]) || (ch != NULL && strcmp(ch, ".bmp") == 0))
     {
         encInfo->src_image_fname = argv[2];
-        printf("INFO ✅ : source image %s validated\n", argv[2]);
+        INFO_PRINTF("INFO ✅ : source image %s validated\n", argv[2]);
     }
     else
     {
@@ -55,7 +109,18 @@ Status read_and_validate_encode_args(char *argv[], EncodeInfo *encInfo)
 
     // Check if secret file has valid extension
     ch = strrchr(argv[3], '.');
-    if ( ch != NULL && strcmp(ch, ".txt") == 0 ) //check for ".txt"
+    if (is_stdio_fname(argv[3])) //secret from stdin, size not known up front
+    {
+        if (is_stdio_fname(argv[2]))
+        {
+            printf("ERROR ❌ : Source image and secret file can't both be stdin\n");
+            return e_failure;
+        }
+        encInfo->secret_fname = argv[3];
+        strcpy(encInfo->extn_secret_file, ""); //no extension to restore
+        encInfo->flags |= STEGO_FLAG_FRAMED;
+    }
+    else if ( ch != NULL && strcmp(ch, ".txt") == 0 ) //check for ".txt"
     {
         encInfo->secret_fname = argv[3];
         strcpy(encInfo->extn_secret_file, ".txt"); //copying ".txt"
@@ -77,18 +142,18 @@ Status read_and_validate_encode_args(char *argv[], EncodeInfo *encInfo)
         return e_failure;
     }
 
-    printf("INFO ✅ : secret file %s validated\n", argv[3]);
+    INFO_PRINTF("INFO ✅ : secret file %s validated\n", argv[3]);
 
     // Check if output file name is provided
     if(argv[4] == NULL)
     {
-        printf("INFO ✅ : Output File not mentioned. Creating stego.bmp as default 🖼️\n");
+        INFO_PRINTF("INFO ✅ : Output File not mentioned. Creating stego.bmp as default 🖼️\n");
         encInfo->stego_image_fname = "stego.bmp"; //naming encoded file name
     }
     else
     {
         ch = strrchr(argv[4], '.'); //check for '.'
-        if(ch != NULL && strcmp(ch, ".bmp") == 0)
+        if(is_stdio_fname(argv[4]) || (ch != NULL && strcmp(ch, ".bmp") == 0))
         {
             encInfo->stego_image_fname = argv[4]; //copy argv[4] as encoded file name
         }
@@ -99,86 +164,169 @@ Status read_and_validate_encode_args(char *argv[], EncodeInfo *encInfo)
         }
     }
 
-    printf("INFO ✅ : Successfully validated all arguments\n\n");
+    INFO_PRINTF("INFO ✅ : Successfully validated all arguments\n\n");
     return e_success;
 }
 
 //Encoding process 
 Status do_encoding(EncodeInfo *encInfo)
 {
-    printf("INFO 📂 : Opening required files\n");
+    INFO_PRINTF("INFO 📂 : Opening required files\n");
     if (open_files(encInfo) == e_failure)
     {
         printf("ERROR ❌ : Failed to open files 📁\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("open_files");
 
-    printf("INFO 🚀 : ## Encoding Procedure Started ##\n\n");
+    INFO_PRINTF("INFO 🚀 : ## Encoding Procedure Started ##\n\n");
 
-    printf("INFO 📏 : Checking for secret.txt size\n");
+    INFO_PRINTF("INFO 📏 : Checking for secret.txt size\n");
     if (check_capacity(encInfo) == e_failure)
     {
         printf("ERROR ❌ : Stego.bmp doesn't have the capacity to encode secret.txt 📄\n");
         return e_failure;
     }
-    printf("INFO 🟢 : Done. Found OK ✅\n\n");
+    INFO_PRINTF("INFO 🟢 : Done. Found OK ✅\n\n");
+    STAGE_DONE("check_capacity");
 
-    printf("INFO 🧩 : Copying Image Header\n");
-    if (copy_bmp_header(encInfo->fptr_src_image, encInfo->fptr_stego_image) == e_failure)
+    INFO_PRINTF("INFO 🧩 : Copying Image Header\n");
+    if (encInfo->use_mmap)
+    {
+        // Whole cover was already copied into the mapped stego image, start at the pixels
+        // and leave out row padding and alpha from there on
+        encInfo->map_pos = encInfo->bmp.pixel_offset;
+        if (bmp_has_gaps(&encInfo->bmp))
+            encInfo->remapped = e_remap_carriers;
+    }
+    else if (encInfo->cloned)
+    {
+        // The clone holds the header already, writing starts at the pixels
+        if (fseeko(encInfo->fptr_stego_image, encInfo->bmp.pixel_offset, SEEK_SET) != 0)
+        {
+            printf("ERROR ❌ : Failed to copy the header 🖼️\n");
+            return e_failure;
+        }
+    }
+    else if (copy_bmp_header(encInfo->bmp_header, encInfo->bmp.pixel_offset, encInfo->fptr_stego_image) == e_failure)
     {
         printf("ERROR ❌ : Failed to copy the header 🖼️\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("copy_bmp_header");
 
-    printf("INFO ✨ : Encoding Magic String Signature\n");
+    INFO_PRINTF("INFO ✨ : Encoding Magic String Signature\n");
     if (encode_magic_string(MAGIC_STRING, encInfo) == e_failure)
     {
         printf("ERROR ❌ : Failed to copy MAGIC STRING 🔐\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("encode_magic_string");
+
+    INFO_PRINTF("INFO 🏷️  : Encoding Stego Header (%d bit depth)\n", encInfo->depth);
+    if (encode_stego_header(encInfo) == e_failure)
+    {
+        printf("ERROR ❌ : Failed to copy stego header 🏷️\n");
+        return e_failure;
+    }
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("encode_stego_header");
 
-    printf("INFO 📦 : Encoding secret File Size\n");
+    if (encInfo->flags & STEGO_FLAG_FEC)
+    {
+        INFO_PRINTF("INFO 🩹 : Encoding FEC Header (%d parity bytes per codeword)\n", encInfo->fec_parity);
+        if (encode_fec_header(encInfo) == e_failure)
+        {
+            printf("ERROR ❌ : Failed to set up FEC 🩹\n");
+            return e_failure;
+        }
+        INFO_PRINTF("INFO ✅ : Done\n\n");
+        STAGE_DONE("encode_fec_header");
+    }
+
+    INFO_PRINTF("INFO 📦 : Encoding secret File Size\n");
     if (encode_secret_file_extn_size(strlen(encInfo->extn_secret_file), encInfo) == e_failure)
     {
         printf("ERROR ❌ : Failed to copy file size 📏\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("encode_secret_file_extn_size");
 
-    printf("INFO 📝 : Encoding secret.txt File Extenstion\n");
+    INFO_PRINTF("INFO 📝 : Encoding secret.txt File Extenstion\n");
     if(encode_secret_file_extn(encInfo->extn_secret_file, encInfo) == e_failure)
     {
         printf("ERROR ❌ : Faile to copy secret file extension 📄\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("encode_secret_file_extn");
 
-    printf("INFO 📏 : Encoding secret.txt File Size\n");
+    INFO_PRINTF("INFO 📏 : Encoding secret.txt File Size\n");
     if (encode_secret_file_size(encInfo->size_secret_file, encInfo) == e_failure)
     {
         printf("ERROR ❌ : Failed to copy secret file size 📐\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("encode_secret_file_size");
+
+    if (encInfo->flags & STEGO_FLAG_SCATTER)
+    {
+        INFO_PRINTF("INFO 🎲 : Keying the scattered region of the pixel array\n");
+        if (encode_scatter_region(encInfo) == e_failure)
+        {
+            printf("ERROR ❌ : Failed to set up scattering 🎲\n");
+            return e_failure;
+        }
+        INFO_PRINTF("INFO ✅ : Done\n\n");
+        STAGE_DONE("encode_scatter_region");
+    }
+
+    if (encInfo->flags & STEGO_FLAG_ENCRYPTED)
+    {
+        INFO_PRINTF("INFO 🔑 : Deriving key and encoding crypto header\n");
+        if (encode_crypt_header(encInfo) == e_failure)
+        {
+            printf("ERROR ❌ : Failed to set up encryption 🔑\n");
+            return e_failure;
+        }
+        INFO_PRINTF("INFO ✅ : Done\n\n");
+        STAGE_DONE("encode_crypt_header");
+    }
 
-    printf("INFO 📂 : Encoding secret.txt File Data\n");
+    INFO_PRINTF("INFO 📂 : Encoding secret.txt File Data\n");
     if (encode_secret_file_data(encInfo) == e_failure)
     {
         printf("ERROR ❌ : Failed to copy the secret file data 💾\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("encode_secret_file_data");
 
-    printf("INFO 🧱 : Copying Left Over Data\n");
-    if (copy_remaining_img_data(encInfo->fptr_src_image, encInfo->fptr_stego_image) == e_failure)
+    if (encInfo->flags & STEGO_FLAG_FEC)
+    {
+        INFO_PRINTF("INFO 🩹 : Encoding FEC parity\n");
+        if (encode_fec_parity(encInfo) == e_failure)
+        {
+            printf("ERROR ❌ : Failed to add FEC parity 🩹\n");
+            return e_failure;
+        }
+        INFO_PRINTF("INFO ✅ : Done\n\n");
+        STAGE_DONE("encode_fec_parity");
+    }
+
+    INFO_PRINTF("INFO 🧱 : Copying Left Over Data\n");
+    if (!encInfo->use_mmap && !encInfo->cloned && copy_remaining_img_data(encInfo->fptr_src_image, encInfo->fptr_stego_image) == e_failure)
     {
         printf("ERROR ❌ : Failed to copy the remaining data 🗃️\n");
         return e_failure;
     }
-    printf("INFO ✅ : Done\n\n");
+    INFO_PRINTF("INFO ✅ : Done\n\n");
+    STAGE_DONE("copy_remaining_img_data");
     
     return e_success;
 }
@@ -186,17 +334,65 @@ Status do_encoding(EncodeInfo *encInfo)
 // Check if source image can handle the data
 Status check_capacity(EncodeInfo *encInfo)
 {
-    int total_capacity ;
-    encInfo->image_capacity = get_image_size_for_bmp(encInfo->fptr_src_image);
-    encInfo->size_secret_file = get_file_size(encInfo->fptr_secret);
+    long total_capacity ;
+    int depth = encInfo->depth;
+    encInfo->image_capacity = get_image_size_for_bmp(encInfo->bmp_header);
+
+    // A framed secret is checked frame by frame while it is read
+    if (encInfo->flags & STEGO_FLAG_FRAMED)
+        encInfo->size_secret_file = 0;
+    else if (encInfo->flags & STEGO_FLAG_CONTAINER)
+    {
+        // Table of contents plus every file, checksummed up front
+        if (container_build(&encInfo->container, encInfo->container_files, encInfo->container_count) == e_failure)
+            return e_failure;
+        encInfo->size_secret_file = encInfo->container.payload_size;
+    }
+    else
+        encInfo->size_secret_file = get_file_size(encInfo->fptr_secret);
+    encInfo->plain_size = encInfo->size_secret_file;
+
+    // Sealed records carry a tag each, framed ones are sized frame by frame
+    if ((encInfo->flags & STEGO_FLAG_ENCRYPTED) && !(encInfo->flags & STEGO_FLAG_FRAMED))
+        encInfo->size_secret_file = aead_stream_size(encInfo->plain_size);
+
+    // Plain and framed secrets get a checksum trailer, container files and sealed records have their own
+    if (!(encInfo->flags & (STEGO_FLAG_CONTAINER | STEGO_FLAG_ENCRYPTED)))
+        encInfo->flags |= STEGO_FLAG_CRC;
 
-    // Calculate total bits required
-    total_capacity = 54 + ((strlen(MAGIC_STRING) + 4 + strlen(encInfo->extn_secret_file) + 4 + encInfo->size_secret_file) * 8);
+    // Calculate total pixel bytes required, magic and stego header use 1 bit, the rest depth bits per byte
+    total_capacity = (strlen(MAGIC_STRING) + STEGO_HEADER_SIZE) * 8
+                     + LSB_COVER_SIZE(4L, depth) + LSB_COVER_SIZE((long)strlen(encInfo->extn_secret_file), depth)
+                     + LSB_COVER_SIZE((long)STEGO_SIZE_BYTES(STEGO_VERSION), depth) + LSB_COVER_SIZE(encInfo->size_secret_file, depth);
+    if (encInfo->flags & STEGO_FLAG_CRC)
+        total_capacity += LSB_COVER_SIZE((long)STEGO_CRC_SIZE, depth);
+
+    // Crypto header, and for frames the empty last record ahead of the 0 length
+    if (encInfo->flags & STEGO_FLAG_ENCRYPTED)
+        total_capacity += LSB_COVER_SIZE((long)AEAD_HEADER_SIZE, depth);
+    if ((encInfo->flags & STEGO_FLAG_ENCRYPTED) && (encInfo->flags & STEGO_FLAG_FRAMED))
+        total_capacity += LSB_COVER_SIZE(4L + AEAD_TAG_SIZE, depth);
+
+    // Scattered data only uses whole cells, the pixels past the last one are lost
+    if (encInfo->flags & STEGO_FLAG_SCATTER)
+        total_capacity += SCATTER_CELL;
+
+    // Past the FEC header only the data parts of whole blocks carry the stego stream, count the capacity in those
+    if (encInfo->flags & STEGO_FLAG_FEC)
+    {
+        long head = (STEGO_FEC_COPIES * STEGO_PREAMBLE_SIZE + STEGO_FEC_HEADER_SIZE) * 8;
+
+        total_capacity += ((STEGO_FEC_COPIES - 1) * STEGO_PREAMBLE_SIZE + STEGO_FEC_HEADER_SIZE) * 8;
+        encInfo->image_capacity = head + fec_capacity(encInfo->fec_parity, depth, encInfo->image_capacity - head);
+    }
 
     if(total_capacity > 0)
-        printf("INFO 🟢 : Done. Not Empty 📁\n\n");
+        INFO_PRINTF("INFO 🟢 : Done. Not Empty 📁\n\n");
+
+    // Framed data adds to this as it goes
+    encInfo->cover_used = total_capacity;
 
-    printf("INFO 📊 : Checking for beautiful.bmp capacity to handle secret.txt 📄\n");
+    INFO_PRINTF("INFO 📊 : Checking for beautiful.bmp capacity to handle secret.txt 📄\n");
     if (encInfo->image_capacity >= total_capacity)
     {
         return e_success;
@@ -207,14 +403,11 @@ Status check_capacity(EncodeInfo *encInfo)
     }
 }
 
-// Copy BMP image header
-Status copy_bmp_header(FILE *fptr_src_image, FILE *fptr_dest_image)
+// Copy BMP image headers, everything before the pixels as read from the src image by open_files()
+Status copy_bmp_header(const char *bmp_header, uint header_size, FILE *fptr_dest_image)
 {
-    char buffer[54];
-    rewind(fptr_src_image);
-    // Read 54 bytes from the src_img
-    fread(buffer, 54, 1, fptr_src_image);
-    fwrite(buffer, 54, 1, fptr_dest_image);
+    if (fwrite(bmp_header, header_size, 1, fptr_dest_image) != 1)
+        return e_failure;
     
     return e_success;
 }
@@ -224,96 +417,980 @@ Status encode_magic_string(const char *magic_string, EncodeInfo *encInfo)
 {
     //call encode_data_to_image()
 
-    if(encode_data_to_image(magic_string, strlen(magic_string), encInfo->fptr_src_image, encInfo->fptr_stego_image) == e_success)
+    if(encode_data_to_image(magic_string, strlen(magic_string), 1, encInfo) == e_success)
         return e_success;
     else 
         return e_failure;
 }
 
+// Encode the stego header : format version and LSB depth of the following fields
+Status encode_stego_header(EncodeInfo *encInfo)
+{
+    char header[STEGO_HEADER_SIZE];
+
+    if (encInfo->depth < LSB_MIN_DEPTH || encInfo->depth > LSB_MAX_DEPTH)
+        return e_failure;
+
+    header[0] = encInfo->version;
+    header[1] = encInfo->depth;
+    header[2] = encInfo->flags;
+
+    return encode_data_to_image(header, STEGO_HEADER_SIZE, 1, encInfo);
+}
+
 // Encode size of file extension
 Status encode_secret_file_extn_size(int extn_size, EncodeInfo *encoInfo)
 {
+    char buffer[4];
+
+    // Big endian bytes, MSB first gives the same bits as encode_int_to_lsb
+    buffer[0] = (extn_size >> 24) & 0xFF;
+    buffer[1] = (extn_size >> 16) & 0xFF;
+    buffer[2] = (extn_size >> 8) & 0xFF;
+    buffer[3] = extn_size & 0xFF;
+
+    return encode_data_to_image(buffer, 4, encoInfo->depth, encoInfo);
+}
+
+// Encode actual file extension (.txt, .sh, etc.)
+Status encode_secret_file_extn(const char *file_extn, EncodeInfo *encInfo)
+{
+    return encode_data_to_image(file_extn, strlen(file_extn), encInfo->depth, encInfo);
+}
+
+//Encode Secret File Size, 64 bit big endian (STEGO_SIZE_BYTES of STEGO_VERSION)
+Status encode_secret_file_size(long file_size, EncodeInfo *encInfo)
+{
+    char buffer[STEGO_MAX_SIZE_BYTES];
+    int i, n = STEGO_SIZE_BYTES(STEGO_VERSION);
+
+    for (i = 0; i < n; i++)
+        buffer[i] = ((unsigned long long)file_size >> (8 * (n - 1 - i))) & 0xFF;
+
+    return encode_data_to_image(buffer, n, encInfo->depth, encInfo);
+}
+
+// Derive the key from the passphrase with a new salt and nonce, and store them
+Status encode_crypt_header(EncodeInfo *encInfo)
+{
+    char header[AEAD_HEADER_SIZE];
+
+    if (aead_new_key(&encInfo->key, encInfo->passphrase, header) == e_failure)
+        return e_failure;
+
+    return encode_data_to_image(header, AEAD_HEADER_SIZE, encInfo->depth, encInfo);
+}
+
+// End of the pixel array in the mapped image, counted in colour bytes when they are remapped
+// Without row padding or alpha every byte of the pixel array is a colour byte
+static long stego_pixel_end(EncodeInfo *encInfo)
+{
+    long end = encInfo->bmp.pixel_offset + encInfo->bmp.pixel_span;
+
+    if (encInfo->remapped == e_remap_carriers)
+        return bmp_carrier_end(&encInfo->bmp, encInfo->image_size);
+    return end < encInfo->image_size ? end : encInfo->image_size;
+}
+
+// Key the scatter permutation over the colour bytes left after the size field
+// map_pos turns into a virtual offset, embed_mapped() finds its cells
+Status encode_scatter_region(EncodeInfo *encInfo)
+{
+    long end = stego_pixel_end(encInfo);
+
+    // Cells are visited in any order, only the mapped stego image has them all at hand
+    if (!encInfo->use_mmap)
+        return e_failure;
+
+    if (scatter_init(&encInfo->scatter, encInfo->scatter_key, encInfo->map_pos, end - encInfo->map_pos,
+                     encInfo->remapped == e_remap_carriers ? &encInfo->bmp : NULL) == e_failure)
+        return e_failure;
+
+    encInfo->remapped = e_remap_scatter;
+    return e_success;
+}
+
+// Repeat the magic string and stego header, store the parity count STEGO_FEC_HEADER_SIZE times at 1 LSB,
+// then lay the FEC blocks over the rest of the colour bytes
+// map_pos turns into a virtual offset, embed_mapped() finds the data parts
+Status encode_fec_header(EncodeInfo *encInfo)
+{
+    char preamble[STEGO_PREAMBLE_SIZE], header[STEGO_FEC_HEADER_SIZE];
+    long end = stego_pixel_end(encInfo);
     int i;
-    char buffer[32];
-    
-    if(fread(buffer, 32, 1, encoInfo->fptr_src_image) != 1)
+
+    // Parity is added over whole blocks once the data is in, only the mapped stego image allows that
+    if (!encInfo->use_mmap)
+        return e_failure;
+
+    // The blocks can't cover what tells the decoder they are there, these copies outvote damage to one instead
+    memcpy(preamble, MAGIC_STRING, strlen(MAGIC_STRING));
+    preamble[strlen(MAGIC_STRING)] = encInfo->version;
+    preamble[strlen(MAGIC_STRING) + 1] = encInfo->depth;
+    preamble[strlen(MAGIC_STRING) + 2] = encInfo->flags;
+    for (i = 1; i < STEGO_FEC_COPIES; i++)
+        if (encode_data_to_image(preamble, STEGO_PREAMBLE_SIZE, 1, encInfo) == e_failure)
+            return e_failure;
+
+    memset(header, encInfo->fec_parity, STEGO_FEC_HEADER_SIZE);
+    if (encode_data_to_image(header, STEGO_FEC_HEADER_SIZE, 1, encInfo) == e_failure)
+        return e_failure;
+
+    if (fec_init(&encInfo->fec, encInfo->fec_parity, encInfo->depth, encInfo->map_pos, end - encInfo->map_pos,
+                 encInfo->remapped == e_remap_carriers ? &encInfo->bmp : NULL) == e_failure ||
+        fec_track(&encInfo->fec) == e_failure)
         return e_failure;
 
-    encode_int_to_lsb(extn_size, buffer);
+    encInfo->remapped = e_remap_fec;
+    return e_success;
+}
+
+// Seal the FEC blocks of [begin, end) that weren't sealed as they filled up
+static Status fec_parity_stripe(void *arg, long begin, long end)
+{
+    EncodeInfo *encInfo = arg;
+
+    return fec_seal(&encInfo->fec, encInfo->stego_map, begin, end);
+}
+
+// Blocks get their checksum and parity in embed_mapped() as the stego stream fills them. What is left is the
+// block the stream ends in, whose cover bytes past the stream are encoded as they are, decoding reads them
+// the same way, and any block whose seal couldn't get memory. Runs on encInfo->threads threads
+Status encode_fec_parity(EncodeInfo *encInfo)
+{
+    return run_stripes(encInfo->threads, fec_blocks_used(&encInfo->fec, encInfo->map_pos), 1, 1, fec_parity_stripe, encInfo);
+}
+
+// Get the scratch arena, allocated once and reused by every stage
+// Layout : ENC_BLOCK_SIZE cover bytes followed by ENC_CHUNK_SIZE payload bytes
+char *enc_arena(EncodeInfo *encInfo)
+{
+    return enc_arena_reserve(encInfo, ENC_ARENA_SIZE);
+}
+
+// Grow the arena to size bytes, the pipeline lays its buffers out in it
+char *enc_arena_reserve(EncodeInfo *encInfo, size_t size)
+{
+    char *grown;
+
+    if (encInfo->arena_size < size)
+    {
+        // Nothing in it is kept from one stage to the next, no need to copy it over
+        grown = malloc(size);
+        if (grown == NULL)
+        {
+            printf("ERROR ❌ : Can't allocate encode buffer 🧠\n");
+            return NULL;
+        }
+        free(encInfo->arena);
+        encInfo->arena = grown;
+        encInfo->arena_size = size;
+    }
+
+    return encInfo->arena;
+}
 
-    fwrite(buffer, 32, 1, encoInfo->fptr_stego_image);
+// End of the offsets map_pos can reach, the last colour byte, whole cell or FEC block once it is remapped
+static long stego_map_end(EncodeInfo *encInfo)
+{
+    switch (encInfo->remapped)
+    {
+        case e_remap_carriers:
+            return stego_pixel_end(encInfo);
+        case e_remap_scatter:
+            return scatter_end(&encInfo->scatter);
+        case e_remap_fec:
+            return fec_end(&encInfo->fec);
+        default:
+            return encInfo->image_size;
+    }
+}
+
+// Copy n cover bytes at offset pos of the remapped stego image into cover
+static void stego_gather(EncodeInfo *encInfo, long pos, long n, char *cover)
+{
+    if (encInfo->remapped == e_remap_fec)
+        fec_gather(&encInfo->fec, encInfo->stego_map, pos, n, cover, NULL);
+    else if (encInfo->remapped == e_remap_scatter)
+        scatter_gather(&encInfo->scatter, encInfo->stego_map, pos, n, cover);
+    else
+        bmp_gather(&encInfo->bmp, encInfo->stego_map, pos, n, cover);
+}
+
+// Copy n cover bytes back to offset pos of the remapped stego image
+static void stego_put(EncodeInfo *encInfo, long pos, long n, const char *cover)
+{
+    if (encInfo->remapped == e_remap_fec)
+        fec_put(&encInfo->fec, encInfo->stego_map, pos, n, cover);
+    else if (encInfo->remapped == e_remap_scatter)
+        scatter_put(&encInfo->scatter, encInfo->stego_map, pos, n, cover);
+    else
+        bmp_put(&encInfo->bmp, encInfo->stego_map, pos, n, cover);
+}
+
+/*
+ * Embed size payload bytes at depth, offset pos of the mapped stego image. On covers with row padding or
+ * alpha pos is a carrier offset, and once the scattered region or the FEC blocks have started a virtual one :
+ * the cover bytes are gathered into cover (ENC_BLOCK_SIZE bytes), embedded in one pass and put back.
+ * pos has to start on a whole cover byte
+ */
+static void embed_mapped(EncodeInfo *encInfo, const char *data, long size, int depth, long pos, char *cover)
+{
+    long chunk;
+
+    if (!encInfo->remapped)
+    {
+        lsb_embed(data, size, encInfo->stego_map + pos, depth);
+        return;
+    }
+
+    // ENC_CHUNK_SIZE is a multiple of LSB_ALIGN, every chunk starts on a whole cover byte
+    for (; size > 0; data += chunk, size -= chunk, pos += LSB_COVER_SIZE(chunk, depth))
+    {
+        chunk = size < ENC_CHUNK_SIZE ? size : ENC_CHUNK_SIZE;
+        stego_gather(encInfo, pos, LSB_COVER_SIZE(chunk, depth), cover);
+        lsb_embed(data, chunk, cover, depth);
+        stego_put(encInfo, pos, LSB_COVER_SIZE(chunk, depth), cover);
+    }
+}
+
+/* Where the secret data starts in the cover and stego image, shared by all stripes */
+typedef struct
+{
+    EncodeInfo *encInfo;
+    off_t src_pos;
+    off_t stego_pos;
+    StripeCrc crc;
+} EncStripeJob;
+
+/*
+ * Fill data with the secret bytes of the records of embedded bytes [begin, begin + chunk), each
+ * followed by room for its tag, begin is a multiple of AEAD_RECORD. Read from the mapping or with pread
+ */
+static Status read_records(EncodeInfo *encInfo, long begin, long chunk, char *data)
+{
+    long index = begin / AEAD_RECORD, pos, n;
+
+    for (; chunk > 0; index++, data += n + AEAD_TAG_SIZE, chunk -= n + AEAD_TAG_SIZE)
+    {
+        pos = index * AEAD_CHUNK;
+        n = encInfo->plain_size - pos < AEAD_CHUNK ? encInfo->plain_size - pos : AEAD_CHUNK;
+
+        if (encInfo->secret_map != NULL)
+            memcpy(data, encInfo->secret_map + pos, n);
+        else if (n > 0 && pread_full(fileno(encInfo->fptr_secret), data, n, pos) == e_failure)
+        {
+            printf("ERROR ❌ : Can't read data in the secret file 📄\n");
+            return e_failure;
+        }
+    }
 
     return e_success;
 }
 
-// Encode actual file extension (.txt, .sh, etc.)
-Status encode_secret_file_extn(const char *file_extn, EncodeInfo *encInfo)
+// Seal the records read_records() put in data, in place
+static Status seal_records(EncodeInfo *encInfo, Aead *aead, long begin, long chunk, char *data)
 {
-    char buffer[strlen(file_extn)];
-    
-    encode_data_to_image(file_extn, strlen(file_extn), encInfo->fptr_src_image, encInfo->fptr_stego_image);
-    
+    long index = begin / AEAD_RECORD, pos, n;
+
+    for (; chunk > 0; index++, data += n + AEAD_TAG_SIZE, chunk -= n + AEAD_TAG_SIZE)
+    {
+        pos = index * AEAD_CHUNK;
+        n = encInfo->plain_size - pos < AEAD_CHUNK ? encInfo->plain_size - pos : AEAD_CHUNK;
+
+        if (aead_seal(aead, index, pos + n >= encInfo->plain_size, data, n) == e_failure)
+        {
+            printf("ERROR ❌ : Can't encrypt the secret file 🔑\n");
+            return e_failure;
+        }
+    }
+
+    return e_success;
+}
+
+// Embed secret bytes [begin, end), begin is a multiple of LSB_ALIGN (AEAD_RECORD when sealing)
+// so it starts at cover byte LSB_COVER_SIZE(begin, depth)
+static Status encode_stripe(void *arg, long begin, long end)
+{
+    EncStripeJob *job = arg;
+    EncodeInfo *encInfo = job->encInfo;
+    int depth = encInfo->depth, sealed = encInfo->flags & STEGO_FLAG_ENCRYPTED;
+    char *arena, *payload;
+    long chunk, first = begin, step = sealed ? ENC_SEALED_CHUNK : ENC_CHUNK_SIZE;
+    uint crc = 0;
+    Aead aead;
+    Status status = e_success;
+
+    if (encInfo->use_mmap && !sealed)
+    {
+        // Colour bytes, scattered cells and FEC data parts are gathered into a cover block of the stripe's own
+        arena = encInfo->remapped ? malloc(ENC_BLOCK_SIZE) : NULL;
+        if (encInfo->remapped && arena == NULL)
+            return e_failure;
+
+        // Chunk by chunk so the checksum reads bytes the embed just pulled into the cache
+        for (; begin < end; begin += chunk)
+        {
+            chunk = end - begin < ENC_CHUNK_SIZE ? end - begin : ENC_CHUNK_SIZE;
+            embed_mapped(encInfo, encInfo->secret_map + begin, chunk, depth, job->stego_pos + LSB_COVER_SIZE(begin, depth), arena);
+            crc = crc32c(crc, encInfo->secret_map + begin, chunk);
+        }
+        stripe_crc_add(&job->crc, first, end, crc);
+        free(arena);
+        return e_success;
+    }
+
+    // Every stripe has its own arena and cipher context and uses positioned I/O, the streams are shared
+    arena = malloc(ENC_ARENA_SIZE);
+    if (arena == NULL)
+        return e_failure;
+    if (sealed && aead_init(&aead, &encInfo->key, 1) == e_failure)
+    {
+        free(arena);
+        return e_failure;
+    }
+    payload = arena + ENC_BLOCK_SIZE;
+
+    while (begin < end && status == e_success)
+    {
+        chunk = step;
+        if (chunk > end - begin)
+            chunk = end - begin;
+
+        if (sealed)
+        {
+            status = read_records(encInfo, begin, chunk, payload);
+            if (status == e_success)
+                status = seal_records(encInfo, &aead, begin, chunk, payload);
+        }
+        else
+            status = pread_full(fileno(encInfo->fptr_secret), payload, chunk, begin);
+        if (status == e_failure)
+            break;
+        crc = crc32c(crc, payload, chunk);
+
+        if (encInfo->use_mmap)
+        {
+            embed_mapped(encInfo, payload, chunk, depth, job->stego_pos + LSB_COVER_SIZE(begin, depth), arena);
+            begin += chunk;
+            continue;
+        }
+
+        if (pread_full(fileno(encInfo->fptr_src_image), arena, LSB_COVER_SIZE(chunk, depth), job->src_pos + LSB_COVER_SIZE(begin, depth)) == e_failure)
+        {
+            status = e_failure;
+            break;
+        }
+
+        lsb_embed(payload, chunk, arena, depth);
+
+        status = pwrite_full(fileno(encInfo->fptr_stego_image), arena, LSB_COVER_SIZE(chunk, depth), job->stego_pos + LSB_COVER_SIZE(begin, depth));
+        begin += chunk;
+    }
+
+    stripe_crc_add(&job->crc, first, end, crc);
+    if (sealed)
+        aead_free(&aead);
+    free(arena);
+    return status;
+}
+
+// Encode the secret data on encInfo->threads threads, one stripe each
+static Status encode_secret_file_data_parallel(EncodeInfo *encInfo)
+{
+    EncStripeJob job;
+    long span = LSB_COVER_SIZE(encInfo->size_secret_file, encInfo->depth);
+    Status status;
+
+    job.encInfo = encInfo;
+    if (encInfo->use_mmap)
+    {
+        job.src_pos = job.stego_pos = encInfo->map_pos;
+    }
+    else
+    {
+        // Hand the current positions over to pread / pwrite
+        if (fflush(encInfo->fptr_stego_image) != 0)
+            return e_failure;
+        job.src_pos = ftello(encInfo->fptr_src_image);
+        job.stego_pos = ftello(encInfo->fptr_stego_image);
+        if (job.src_pos < 0 || job.stego_pos < 0)
+            return e_failure;
+    }
+
+    if (stripe_crc_init(&job.crc, encInfo->threads) == e_failure)
+        return e_failure;
+    // Sealed stripes start on a record
+    status = run_stripes(encInfo->threads, encInfo->size_secret_file, ENC_CHUNK_SIZE,
+                         encInfo->flags & STEGO_FLAG_ENCRYPTED ? AEAD_RECORD : LSB_ALIGN, encode_stripe, &job);
+    encInfo->crc = stripe_crc_finish(&job.crc);
+    if (status == e_failure)
+        return e_failure;
+
+    // Continue after the embedded data like the sequential path does
+    if (encInfo->use_mmap)
+    {
+        encInfo->map_pos += span;
+        return e_success;
+    }
+
+    if (fseeko(encInfo->fptr_src_image, job.src_pos + span, SEEK_SET) != 0 ||
+        fseeko(encInfo->fptr_stego_image, job.stego_pos + span, SEEK_SET) != 0)
+        return e_failure;
+
     return e_success;
 }
 
-//Encode Secret File Size
-Status encode_secret_file_size(int file_size, EncodeInfo *encInfo)
+// Encode one frame : 4 byte big endian length then the data, a 0 length frame ends the data
+static Status encode_frame(const char *data, size_t size, EncodeInfo *encInfo)
 {
-    char buffer[file_size];
-    if(fread(buffer, 32, 1, encInfo->fptr_src_image) != 1)
+    char length[4];
+    long frame_cover;
+
+    // Room for this frame and the closing 0 length
+    frame_cover = LSB_COVER_SIZE((long)size, encInfo->depth);
+    if (size > 0)
+        frame_cover += LSB_COVER_SIZE(4L, encInfo->depth);
+    if (encInfo->cover_used + frame_cover + LSB_COVER_SIZE(4L, encInfo->depth) > encInfo->image_capacity)
+    {
+        printf("ERROR ❌ : Image doesn't have the capacity for the rest of the secret data 📄\n");
         return e_failure;
+    }
+    encInfo->cover_used += frame_cover;
 
-    encode_int_to_lsb(file_size, buffer);
+    length[0] = (size >> 24) & 0xFF;
+    length[1] = (size >> 16) & 0xFF;
+    length[2] = (size >> 8) & 0xFF;
+    length[3] = size & 0xFF;
 
-    fwrite(buffer, 32, 1, encInfo->fptr_stego_image);
+    if (encode_data_to_image(length, 4, encInfo->depth, encInfo) == e_failure ||
+        encode_data_to_image(data, size, encInfo->depth, encInfo) == e_failure)
+        return e_failure;
 
     return e_success;
 }
 
-// Encode the actual content of secret file
-Status encode_secret_file_data(EncodeInfo *encInfo)
+// Encode data as sealed frames, one record of up to AEAD_CHUNK bytes per frame
+// size 0 seals the empty last record
+static Status encode_sealed_frames(const char *data, size_t size, EncodeInfo *encInfo)
 {
-    char buffer[encInfo->size_secret_file];
-    rewind(encInfo->fptr_secret);
+    char *record;
+    size_t n;
+    Aead aead;
+    Status status = e_success;
+
+    record = malloc(AEAD_RECORD);
+    if (record == NULL || aead_init(&aead, &encInfo->key, 1) == e_failure)
+    {
+        free(record);
+        return e_failure;
+    }
 
-    if(fread(buffer, encInfo->size_secret_file, 1, encInfo->fptr_secret) != 1)
+    do
+    {
+        n = size < AEAD_CHUNK ? size : AEAD_CHUNK;
+        if (n > 0)
+            memcpy(record, data, n);
+        if (aead_seal(&aead, encInfo->records++, size == 0, record, n) == e_failure)
+            status = e_failure;
+        else
+            status = encode_frame(record, n + AEAD_TAG_SIZE, encInfo);
+        data += n;
+        size -= n;
+    } while (status == e_success && size > 0);
+
+    aead_free(&aead);
+    free(record);
+    return status;
+}
+
+// Frame data, sealing it first with --passphrase
+static Status encode_data_frames(const char *data, size_t size, EncodeInfo *encInfo)
+{
+    if (encInfo->flags & STEGO_FLAG_ENCRYPTED)
+        return encode_sealed_frames(data, size, encInfo);
+    return encode_frame(data, size, encInfo);
+}
+
+// Deflate a block of the secret, every full output buffer becomes a frame
+// finish flushes the rest of the zlib stream
+static Status encode_deflate_block(z_stream *zs, char *zbuf, int finish, EncodeInfo *encInfo)
+{
+    size_t n;
+
+    do
+    {
+        zs->next_out = (Bytef *)zbuf;
+        zs->avail_out = ENC_CHUNK_SIZE;
+        if (deflate(zs, finish ? Z_FINISH : Z_NO_FLUSH) == Z_STREAM_ERROR)
+            return e_failure;
+
+        n = ENC_CHUNK_SIZE - zs->avail_out;
+        if (n > 0 && encode_data_frames(zbuf, n, encInfo) == e_failure)
+            return e_failure;
+    } while (zs->avail_out == 0);
+
+    return e_success;
+}
+
+// Encode a secret as length prefixed frames, used when its size isn't known up front
+// (stdin) or when it is compressed. Frames hold up to ENC_CHUNK_SIZE bytes
+static Status encode_secret_file_data_framed(EncodeInfo *encInfo)
+{
+    char *buffer, *zbuf = NULL;
+    size_t chunk;
+    z_stream zs;
+    int compress = encInfo->flags & STEGO_FLAG_DEFLATE;
+    Status status = e_success;
+
+    if (enc_arena(encInfo) == NULL)
+        return e_failure;
+    buffer = encInfo->arena + ENC_BLOCK_SIZE;
+
+    if (!is_stdio_fname(encInfo->secret_fname))
+        rewind(encInfo->fptr_secret);
+
+    if (compress)
+    {
+        memset(&zs, 0, sizeof(zs));
+        zbuf = malloc(ENC_CHUNK_SIZE);
+        if (zbuf == NULL || deflateInit(&zs, STEGO_ZLIB_LEVEL) != Z_OK)
+        {
+            printf("ERROR ❌ : Can't start compression 🗜️\n");
+            free(zbuf);
+            return e_failure;
+        }
+    }
+
+    do
+    {
+        chunk = fread(buffer, 1, ENC_CHUNK_SIZE, encInfo->fptr_secret);
+        if (ferror(encInfo->fptr_secret))
+        {
+            printf("ERROR ❌ : Can't read data in the secret file 📄\n");
+            status = e_failure;
+            break;
+        }
+        encInfo->size_secret_file += chunk;
+        encInfo->crc = crc32c(encInfo->crc, buffer, chunk);
+
+        if (compress)
+        {
+            zs.next_in = (Bytef *)buffer;
+            zs.avail_in = chunk;
+            status = encode_deflate_block(&zs, zbuf, chunk < ENC_CHUNK_SIZE, encInfo);
+        }
+        else if (chunk > 0)
+        {
+            status = encode_data_frames(buffer, chunk, encInfo);
+        }
+    } while (status == e_success && chunk == ENC_CHUNK_SIZE);
+
+    if (compress)
+    {
+        if (status == e_success)
+            INFO_PRINTF("INFO 🗜️  : Compressed %ld bytes to %lu bytes\n", encInfo->size_secret_file, zs.total_out);
+        deflateEnd(&zs);
+        free(zbuf);
+    }
+
+    if (status == e_failure)
+        return e_failure;
+
+    // Sealed frames end with the empty last record, a cut off secret can't pass as whole
+    // check_capacity() kept room for it, encode_frame() counts it again
+    if (encInfo->flags & STEGO_FLAG_ENCRYPTED)
+    {
+        encInfo->cover_used -= LSB_COVER_SIZE(4L + AEAD_TAG_SIZE, encInfo->depth);
+        if (encode_sealed_frames(NULL, 0, encInfo) == e_failure)
+            return e_failure;
+    }
+
+    return encode_frame(NULL, 0, encInfo);
+}
+
+// Encode the table of contents, then every container file zero padded to LSB_ALIGN
+static Status encode_secret_file_data_container(EncodeInfo *encInfo)
+{
+    Container *container = &encInfo->container;
+    char *buffer, *toc;
+    FILE *fptr;
+    long remaining, chunk, padded;
+    int i;
+    Status status = e_success;
+
+    if (enc_arena(encInfo) == NULL)
+        return e_failure;
+    buffer = encInfo->arena + ENC_BLOCK_SIZE;
+
+    // The table can outgrow a chunk with many long names, it gets its own buffer
+    toc = malloc(container->toc_size);
+    if (toc == NULL)
+        return e_failure;
+    container_write_toc(container, toc);
+    status = encode_data_to_image(toc, container->toc_size, encInfo->depth, encInfo);
+    free(toc);
+
+    for (i = 0; i < container->count && status == e_success; i++)
+    {
+        ContainerEntry *entry = &container->entries[i];
+
+        fptr = fopen(entry->path, "r");
+        if (fptr == NULL)
+        {
+            perror("fopen ");
+            printf("ERROR ❌ : Unable to open file %s\n", entry->path);
+            return e_failure;
+        }
+
+        for (remaining = entry->size; remaining > 0 && status == e_success; remaining -= chunk)
+        {
+            chunk = remaining < ENC_CHUNK_SIZE ? remaining : ENC_CHUNK_SIZE;
+            if (fread(buffer, chunk, 1, fptr) != 1)
+            {
+                printf("ERROR ❌ : %s changed while it was encoded 📄\n", entry->path);
+                status = e_failure;
+                break;
+            }
+
+            // ENC_CHUNK_SIZE is a multiple of LSB_ALIGN, so only the last chunk needs padding
+            padded = (chunk + LSB_ALIGN - 1) / LSB_ALIGN * LSB_ALIGN;
+            memset(buffer + chunk, 0, padded - chunk);
+            status = encode_data_to_image(buffer, padded, encInfo->depth, encInfo);
+        }
+
+        fclose(fptr);
+        INFO_PRINTF("INFO 📦 : Added %s (%ld bytes)\n", entry->name, entry->size);
+    }
+
+    return status;
+}
+
+/* Streamed secret data going through run_pipeline(), every buffer is laid out like the arena */
+typedef struct
+{
+    EncodeInfo *encInfo;
+    Aead aead;
+    long step;
+} EncPipeJob;
+
+// Secret bytes of pipeline block index
+static long enc_pipe_chunk(EncPipeJob *job, long index)
+{
+    long left = job->encInfo->size_secret_file - index * job->step;
+
+    return left < job->step ? left : job->step;
+}
+
+// Reader : the secret bytes of a block (the records before sealing) and the cover bytes for them
+static Status enc_pipe_read(void *arg, long index, char *buffer)
+{
+    EncPipeJob *job = arg;
+    EncodeInfo *encInfo = job->encInfo;
+    long chunk = enc_pipe_chunk(job, index);
+
+    if (encInfo->flags & STEGO_FLAG_ENCRYPTED)
+    {
+        if (read_records(encInfo, index * job->step, chunk, buffer + ENC_BLOCK_SIZE) == e_failure)
+            return e_failure;
+    }
+    else if (fread(buffer + ENC_BLOCK_SIZE, chunk, 1, encInfo->fptr_secret) != 1)
     {
         printf("ERROR ❌ : Can't read data in the secret file 📄\n");
         return e_failure;
     }
 
-    if(encode_data_to_image(buffer, encInfo->size_secret_file, encInfo->fptr_src_image, encInfo->fptr_stego_image) == e_failure)
+    if (fread(buffer, LSB_COVER_SIZE(chunk, encInfo->depth), 1, encInfo->fptr_src_image) != 1)
+        return e_failure;
+
+    return e_success;
+}
+
+// Worker : seal or checksum the block, then embed it
+static Status enc_pipe_work(void *arg, long index, char *buffer)
+{
+    EncPipeJob *job = arg;
+    EncodeInfo *encInfo = job->encInfo;
+    long chunk = enc_pipe_chunk(job, index);
+    char *payload = buffer + ENC_BLOCK_SIZE;
+
+    if (encInfo->flags & STEGO_FLAG_ENCRYPTED)
     {
+        if (seal_records(encInfo, &job->aead, index * job->step, chunk, payload) == e_failure)
+            return e_failure;
+    }
+    else
+        encInfo->crc = crc32c(encInfo->crc, payload, chunk);
+
+    lsb_embed(payload, chunk, buffer, encInfo->depth);
+    return e_success;
+}
+
+// Writer : the stego bytes of the block
+static Status enc_pipe_write(void *arg, long index, char *buffer)
+{
+    EncPipeJob *job = arg;
+    EncodeInfo *encInfo = job->encInfo;
+
+    if (fwrite(buffer, LSB_COVER_SIZE(enc_pipe_chunk(job, index), encInfo->depth), 1, encInfo->fptr_stego_image) != 1)
+        return e_failure;
+
+    return e_success;
+}
+
+// Encode the secret one block at a time through ENC_PIPE_BUFFERS arena blocks, the next blocks
+// of the secret and cover are read and the last ones written while a block is embedded
+// Secrets of one or two blocks, and batch workers (the pool keeps the cores busy), go block by block instead
+static Status encode_secret_file_data_stream(EncodeInfo *encInfo)
+{
+    EncPipeJob job;
+    int sealed = encInfo->flags & STEGO_FLAG_ENCRYPTED, nbuffers = ENC_PIPE_BUFFERS;
+    long count;
+    char *buffers;
+    Status status;
+
+    job.encInfo = encInfo;
+    job.step = sealed ? ENC_SEALED_CHUNK : ENC_CHUNK_SIZE;
+    count = (encInfo->size_secret_file + job.step - 1) / job.step;
+
+    if (count <= 2 || !encInfo->pipelined)
+        nbuffers = 1;
+    if ((buffers = enc_arena_reserve(encInfo, (size_t)nbuffers * ENC_ARENA_SIZE)) == NULL)
+        return e_failure;
+
+    // Sealed records are read with pread, plain blocks in order from the stream
+    if (sealed && aead_init(&job.aead, &encInfo->key, 1) == e_failure)
         return e_failure;
+    if (!sealed)
+        rewind(encInfo->fptr_secret);
+
+    status = run_pipeline(buffers, nbuffers, ENC_ARENA_SIZE, count, enc_pipe_read, enc_pipe_work, enc_pipe_write, &job);
+
+    if (sealed)
+        aead_free(&job.aead);
+    return status;
+}
+
+// Embed straight from the mapped secret file, checksumming each chunk as it goes
+static Status encode_secret_file_data_mmap(EncodeInfo *encInfo)
+{
+    long pos, chunk;
+
+    for (pos = 0; pos < encInfo->size_secret_file; pos += chunk)
+    {
+        chunk = encInfo->size_secret_file - pos < ENC_CHUNK_SIZE ? encInfo->size_secret_file - pos : ENC_CHUNK_SIZE;
+        encInfo->crc = crc32c(encInfo->crc, encInfo->secret_map + pos, chunk);
+        if (encode_data_to_image(encInfo->secret_map + pos, chunk, encInfo->depth, encInfo) == e_failure)
+            return e_failure;
     }
 
     return e_success;
 }
 
+// Seal the secret record by record and embed it in the mapped stego image, whole records per block
+static Status encode_secret_file_data_sealed(EncodeInfo *encInfo)
+{
+    char *buffer;
+    long pos, chunk;
+    Aead aead;
+    Status status = e_success;
+
+    if (enc_arena(encInfo) == NULL || aead_init(&aead, &encInfo->key, 1) == e_failure)
+        return e_failure;
+    buffer = encInfo->arena + ENC_BLOCK_SIZE;
+
+    for (pos = 0; pos < encInfo->size_secret_file && status == e_success; pos += chunk)
+    {
+        chunk = encInfo->size_secret_file - pos < ENC_SEALED_CHUNK ? encInfo->size_secret_file - pos : ENC_SEALED_CHUNK;
+        status = read_records(encInfo, pos, chunk, buffer);
+        if (status == e_success)
+            status = seal_records(encInfo, &aead, pos, chunk, buffer);
+        if (status == e_success)
+            status = encode_data_to_image(buffer, chunk, encInfo->depth, encInfo);
+    }
+
+    aead_free(&aead);
+    return status;
+}
+
+// Encode the actual content of secret file, followed by its checksum
+Status encode_secret_file_data(EncodeInfo *encInfo)
+{
+    Status status;
+
+    encInfo->crc = 0;
+
+    if (encInfo->flags & STEGO_FLAG_FRAMED)
+        status = encode_secret_file_data_framed(encInfo);
+    else if (encInfo->flags & STEGO_FLAG_CONTAINER)
+        status = encode_secret_file_data_container(encInfo);
+    else if (encInfo->threads > 1)
+        status = encode_secret_file_data_parallel(encInfo);
+    else if ((encInfo->flags & STEGO_FLAG_ENCRYPTED) && encInfo->use_mmap)
+        status = encode_secret_file_data_sealed(encInfo);
+    else if (encInfo->use_mmap)
+        status = encode_secret_file_data_mmap(encInfo);
+    else
+        status = encode_secret_file_data_stream(encInfo);
+
+    if (status == e_failure || !(encInfo->flags & STEGO_FLAG_CRC))
+        return status;
+
+    return encode_secret_file_crc(encInfo->crc, encInfo);
+}
+
+// Encode the CRC-32C trailer, big endian
+Status encode_secret_file_crc(uint crc, EncodeInfo *encInfo)
+{
+    char buffer[STEGO_CRC_SIZE];
+
+    buffer[0] = (crc >> 24) & 0xFF;
+    buffer[1] = (crc >> 16) & 0xFF;
+    buffer[2] = (crc >> 8) & 0xFF;
+    buffer[3] = crc & 0xFF;
+
+    INFO_PRINTF("INFO 🧮 : Secret checksum crc32c %08x\n", crc);
+    return encode_data_to_image(buffer, STEGO_CRC_SIZE, encInfo->depth, encInfo);
+}
+
+#ifdef __linux__
+// Copy the rest of src into dest inside the kernel (copy_file_range, then sendfile)
+// Both streams are left positioned after the bytes that were copied
+static Status copy_remaining_img_data_kernel(FILE *fptr_src, FILE *fptr_dest)
+{
+    int fd_src = fileno(fptr_src), fd_dest = fileno(fptr_dest);
+    off_t off_src, off_dest;
+    struct stat st;
+    ssize_t ret = 0;
+    int use_sendfile = 0;
+
+    if (fflush(fptr_dest) != 0)
+        return e_failure;
+
+    off_src = ftello(fptr_src);
+    off_dest = ftello(fptr_dest);
+    if (off_src < 0 || off_dest < 0 || fstat(fd_src, &st) != 0 || !S_ISREG(st.st_mode))
+        return e_failure;
+
+    while (off_src < st.st_size)
+    {
+        size_t len = st.st_size - off_src;
+
+        if (!use_sendfile)
+        {
+            ret = copy_file_range(fd_src, &off_src, fd_dest, &off_dest, len, 0);
+            if (ret < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP))
+            {
+                // Not supported between these files, sendfile needs the fd offset set
+                if (lseek(fd_dest, off_dest, SEEK_SET) < 0)
+                    break;
+                use_sendfile = 1;
+                continue;
+            }
+        }
+        else
+        {
+            ret = sendfile(fd_dest, fd_src, &off_src, len);
+            if (ret > 0)
+                off_dest += ret;
+        }
+
+        if (ret <= 0)
+            break;
+    }
+
+    // Resync stdio with the kernel offsets, a partial copy is finished by the caller
+    if (fseeko(fptr_src, off_src, SEEK_SET) != 0 || fseeko(fptr_dest, off_dest, SEEK_SET) != 0)
+        return e_failure;
+
+    return off_src >= st.st_size ? e_success : e_failure;
+}
+#endif
+
 // Copy leftover image data
 Status copy_remaining_img_data(FILE *fptr_src, FILE *fptr_dest)
 {
-    char ch;
-    while (fread(&ch, 1, 1, fptr_src) > 0)
+    char *buffer;
+    size_t n;
+
+#ifdef __linux__
+    if (copy_remaining_img_data_kernel(fptr_src, fptr_dest) == e_success)
+        return e_success;
+#endif
+
+    // Fallback : copy through a large user space buffer
+    buffer = malloc(ENC_BLOCK_SIZE);
+    if (buffer == NULL)
     {
-        fwrite(&ch, 1, 1, fptr_dest);
+        printf("ERROR ❌ : Can't allocate copy buffer 🧠\n");
+        return e_failure;
     }
-    return e_success;
+
+    while ((n = fread(buffer, 1, ENC_BLOCK_SIZE, fptr_src)) > 0)
+    {
+        if (fwrite(buffer, 1, n, fptr_dest) != n)
+        {
+            free(buffer);
+            return e_failure;
+        }
+    }
+
+    free(buffer);
+    return ferror(fptr_src) ? e_failure : e_success;
 }
 
 // Encode buffer of data into image (bit-by-bit)
-Status encode_data_to_image(const char *data, int size, FILE *fptr_src_image, FILE *fptr_stego_image)
+// Cover bytes are pulled in blocks of up to ENC_BLOCK_SIZE, every payload byte of
+// the block is embedded depth bits per cover byte in one pass and the block is
+// written out in one call
+Status encode_data_to_image(const char *data, long size, int depth, EncodeInfo *encInfo)
 {
-    // call encode_byte_to_lsb
-    int i;
-    char buffer[8];
-    
-    for (i = 0; i < size; i++)
+    long chunk;
+    char *buffer;
+
+    if (size <= 0)
+        return e_success;
+
+    if (encInfo->use_mmap)
     {
-        fread(buffer, 8, 1, fptr_src_image);
-        encode_byte_to_lsb(data[i], buffer);
-        fwrite(buffer, 8, 1, fptr_stego_image);
+        // Embed in place, the mapped stego image already holds the cover bytes
+        if (encInfo->map_pos + LSB_COVER_SIZE(size, depth) > stego_map_end(encInfo))
+            return e_failure;
+
+        // Scattered cells and FEC data parts are gathered into the cover part of the arena
+        buffer = encInfo->remapped ? enc_arena(encInfo) : NULL;
+        if (encInfo->remapped && buffer == NULL)
+            return e_failure;
+
+        embed_mapped(encInfo, data, size, depth, encInfo->map_pos, buffer);
+        encInfo->map_pos += LSB_COVER_SIZE(size, depth);
+        return e_success;
     }
+
+    // Cover part of the arena holds the cover bytes for ENC_CHUNK_SIZE secret bytes
+    buffer = enc_arena(encInfo);
+    if (buffer == NULL)
+        return e_failure;
+    chunk = ENC_CHUNK_SIZE;
+
+    while (size > 0)
+    {
+        if (chunk > size)
+            chunk = size;
+
+        if (fread(buffer, LSB_COVER_SIZE(chunk, depth), 1, encInfo->fptr_src_image) != 1)
+            return e_failure;
+
+        // Vectorized equivalent of encode_byte_to_lsb over the whole block
+        lsb_embed(data, chunk, buffer, depth);
+
+        if (fwrite(buffer, LSB_COVER_SIZE(chunk, depth), 1, encInfo->fptr_stego_image) != 1)
+            return e_failure;
+
+        data += chunk;
+        size -= chunk;
+    }
+
     return e_success;
 }
 
@@ -353,11 +1430,11 @@ Status encode_int_to_lsb(int data, char *image_buffer)
 }
 
 //Get file size
-uint get_file_size(FILE *fptr)
+long get_file_size(FILE *fptr)
 {
-    //get secret file size
-    fseek(fptr, 0, SEEK_END);
-    return ftell(fptr);
+    //get secret file size, off_t offsets so files past 2 GB work everywhere
+    fseeko(fptr, 0, SEEK_END);
+    return ftello(fptr);
 }
 
 // Close all opened files
@@ -365,12 +1442,21 @@ Status close_enc_files(EncodeInfo *encInfo)
 {
     int flag = 0;
 
+    // Drop the mappings before the files behind them are closed
+    unmap_files(encInfo);
+
+    free(encInfo->arena);
+    encInfo->arena = NULL;
+    encInfo->arena_size = 0;
+    container_free(&encInfo->container);
+    fec_free(&encInfo->fec);
+
     if (encInfo->fptr_src_image != NULL)
     {
         flag = 1;
         fclose(encInfo->fptr_src_image);
         encInfo->fptr_src_image = NULL;
-        printf("INFO 🔒 : Closed %s 📷\n", encInfo->src_image_fname);
+        INFO_PRINTF("INFO 🔒 : Closed %s 📷\n", encInfo->src_image_fname);
     }
     
     if(encInfo->fptr_secret != NULL)
@@ -378,7 +1464,7 @@ Status close_enc_files(EncodeInfo *encInfo)
         flag = 1;
         fclose(encInfo->fptr_secret);
         encInfo->fptr_src_image = NULL;
-        printf("INFO 🔒 : Closed %s 📄\n", encInfo->secret_fname);
+        INFO_PRINTF("INFO 🔒 : Closed %s 📄\n", encInfo->secret_fname);
     }
 
     if(encInfo->fptr_stego_image != NULL)
@@ -386,10 +1472,10 @@ Status close_enc_files(EncodeInfo *encInfo)
         flag = 1;
         fclose(encInfo->fptr_stego_image);
         encInfo->fptr_src_image = NULL;
-        printf("INFO 🔒 : Closed %s 🖼️\n", encInfo->stego_image_fname);
+        INFO_PRINTF("INFO 🔒 : Closed %s 🖼️\n", encInfo->stego_image_fname);
     }
 
     if(flag)
-        printf("INFO ✅ : All files closed 🔚\n\n");
+        INFO_PRINTF("INFO ✅ : All files closed 🔚\n\n");
     return e_success;
 }
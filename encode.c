@@ -5,35 +5,156 @@ Date        :30/07/2025
 Description :Steganography Project
 */
 
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "encode.h"
 #include "types.h"
+#include "common.h"
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+/* Bytes checked at a time by copy_sparse() */
+#define SPARSE_PAGE 4096
+
+/* Progress messages are printed unless this is set */
+int stego_quiet = 0;
+
+/* Stage callback, set by the benchmark */
+StageHook stego_stage_hook = NULL;
 
 /* Function Definitions */
 
 /* Get image size
- * Input: Image file ptr
- * Output: width * height * bytes per pixel (3 in our case)
- * Description: In BMP Image, width is stored in offset 18,
- * and height after that. size is 4 bytes
+ * Input: BMP header bytes, as read by open_files()
+ * Output: colour bytes of the pixel array, 0 if the header isn't supported
+ * Description: Parsed by bmp_parse_header(), the pixel array starts at
+ * bfOffBits and holds height rows of width * bpp / 8 bytes padded to 4,
+ * data only goes into the width * 3 colour bytes of each row
+ */
+
+long get_image_size_for_bmp(const char *bmp_header)
+{
+    BmpInfo bmp;
+
+    if (bmp_parse_header(bmp_header, BMP_HEADER_SIZE, &bmp) == e_failure)
+        return 0;
+
+    // Return image capacity, the same count stego_capacity() starts from
+    return bmp.carriers;
+}
+
+/* Non zero if fname stands for stdin / stdout */
+int is_stdio_fname(const char *fname)
+{
+    return strcmp(fname, STDIO_FNAME) == 0;
+}
+
+/* Descriptor holding the real stdout once it is claimed for data */
+static int stdout_data_fd = -1;
+
+/*
+ * Claim stdout for data
+ * The real stdout moves to a private descriptor and fd 1 is pointed
+ * at stderr, so progress messages can't end up in the data stream
+ * Called while validating arguments, before anything is printed
  */
+Status stego_claim_stdout(void)
+{
+    if (stdout_data_fd >= 0)
+        return e_success;
+
+    fflush(stdout);
+    stdout_data_fd = dup(STDOUT_FILENO);
+    if (stdout_data_fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0)
+        return e_failure;
+
+    return e_success;
+}
+
+/*
+ * Open a file, STDIO_FNAME is stdin for reading and stdout for writing
+ */
+FILE *stego_fopen(const char *fname, const char *mode)
+{
+    FILE *fptr;
+
+    if (!is_stdio_fname(fname))
+        return fopen(fname, mode);
+
+    if (mode[0] == 'r')
+        return stdin;
 
-uint get_image_size_for_bmp(FILE *fptr_image)
+    if (stego_claim_stdout() == e_failure)
+        return NULL;
+
+    // The stream owns the descriptor from now on
+    fptr = fdopen(stdout_data_fd, "w");
+    if (fptr != NULL)
+        stdout_data_fd = -1;
+
+    return fptr;
+}
+
+#ifdef __linux__
+/*
+ * Make the stego image a copy of the whole cover inside the kernel. FICLONE shares the
+ * cover's blocks on btrfs / XFS, so only the blocks encoding writes to get copied.
+ * Without a clone, --mmap falls back to copy_file_range (a server side copy on NFS)
+ * while the stream path keeps copying what follows the data, which it needs anyway
+ */
+static Status clone_cover(EncodeInfo *encInfo)
 {
-    uint width, height;
-    // Seek to 18th byte
-    fseek(fptr_image, 18, SEEK_SET);
+    int fd_src = fileno(encInfo->fptr_src_image), fd_dest = fileno(encInfo->fptr_stego_image);
+    off_t off_src = 0, off_dest = 0;
+    struct stat st;
+    ssize_t ret;
+
+    if (fstat(fd_src, &st) != 0 || !S_ISREG(st.st_mode))
+        return e_failure;
+
+#ifdef FICLONE
+    if (ioctl(fd_dest, FICLONE, fd_src) == 0)
+    {
+        INFO_PRINTF("INFO 🧬 : Cloned beautiful.bmp, only the pixels that change get written\n");
+        return e_success;
+    }
+#endif
+    if (!encInfo->use_mmap)
+        return e_failure;
+
+    while (off_src < st.st_size)
+    {
+        ret = copy_file_range(fd_src, &off_src, fd_dest, &off_dest, st.st_size - off_src, 0);
+        if (ret <= 0)
+        {
+            // map_files() copies the cover itself into an empty file
+            if (ftruncate(fd_dest, 0) != 0)
+                perror("ftruncate ");
+            return e_failure;
+        }
+    }
 
-    // Read the width (an int)
-    fread(&width, sizeof(int), 1, fptr_image);
-    //printf("width = %u\n", width);
+    return e_success;
+}
+#endif
 
-    // Read the height (an int)
-    fread(&height, sizeof(int), 1, fptr_image);
-    //printf("height = %u\n", height);
+// memcpy that leaves out the pages of zeros in src, dest has to read as zeros already
+static void copy_sparse(char *dest, const char *src, long size)
+{
+    long pos, n;
 
-    // Return image capacity
-    return width * height * 3;
+    for (pos = 0; pos < size; pos += n)
+    {
+        n = size - pos < SPARSE_PAGE ? size - pos : SPARSE_PAGE;
+        if (src[pos] != 0 || memcmp(src + pos, src + pos + 1, n - 1) != 0)
+            memcpy(dest + pos, src + pos, n);
+    }
 }
 
 /* 
@@ -45,9 +166,22 @@ uint get_image_size_for_bmp(FILE *fptr_image)
  */
 Status open_files(EncodeInfo *encInfo)
 {
+    int piped = is_stdio_fname(encInfo->src_image_fname) || is_stdio_fname(encInfo->stego_image_fname);
+
+    // --mmap and -j N need real files
+    if (piped || is_stdio_fname(encInfo->secret_fname))
+    {
+    	if (encInfo->use_mmap)
+    	{
+    	    fprintf(stderr, "ERROR ❌ : --mmap, --scatter and --fec can't be used with stdin / stdout\n");
+    	    return e_failure;
+    	}
+    	encInfo->threads = 1;
+    }
+
     // Src Image file
     
-    encInfo->fptr_src_image = fopen(encInfo->src_image_fname, "r");
+    encInfo->fptr_src_image = stego_fopen(encInfo->src_image_fname, "r");
     // Do Error handling
     if (encInfo->fptr_src_image == NULL)
     {
@@ -55,10 +189,38 @@ Status open_files(EncodeInfo *encInfo)
     	fprintf(stderr, "ERROR ❌ : Unable to open file %s\n", encInfo->src_image_fname);
     	return e_failure;
     }
-    printf("INFO 📂 : Opened beautiful.bmp ✅\n");
+    INFO_PRINTF("INFO 📂 : Opened beautiful.bmp ✅\n");
+
+    // Keep the headers up to the pixels, a piped cover can't be read twice
+    if (fread(encInfo->bmp_header, BMP_HEADER_SIZE, 1, encInfo->fptr_src_image) != 1)
+    {
+    	fprintf(stderr, "ERROR ❌ : Unable to read BMP header of %s\n", encInfo->src_image_fname);
+    	return e_failure;
+    }
+    if (bmp_parse_header(encInfo->bmp_header, BMP_HEADER_SIZE, &encInfo->bmp) == e_failure)
+    {
+    	fprintf(stderr, "ERROR ❌ : %s : %s\n", encInfo->src_image_fname, encInfo->bmp.error);
+    	return e_failure;
+    }
+    if (encInfo->bmp.pixel_offset > BMP_HEADER_SIZE &&
+        fread(encInfo->bmp_header + BMP_HEADER_SIZE, encInfo->bmp.pixel_offset - BMP_HEADER_SIZE, 1, encInfo->fptr_src_image) != 1)
+    {
+    	fprintf(stderr, "ERROR ❌ : Unable to read BMP header of %s\n", encInfo->src_image_fname);
+    	return e_failure;
+    }
+
+    // Row padding and alpha are skipped by going through the mapped stego image, piped images keep the old layout
+    encInfo->version = STEGO_VERSION;
+    if (bmp_has_gaps(&encInfo->bmp) && piped)
+    {
+    	encInfo->version = STEGO_VERSION_CONTIGUOUS;
+    	INFO_PRINTF("INFO ⚠️  : Piped image, data also goes into its row padding and alpha bytes\n");
+    }
+    else if (bmp_has_gaps(&encInfo->bmp))
+    	encInfo->use_mmap = 1;
 
     // Secret file
-    encInfo->fptr_secret = fopen(encInfo->secret_fname, "r");
+    encInfo->fptr_secret = stego_fopen(encInfo->secret_fname, "r");
     // Do Error handling
     if (encInfo->fptr_secret == NULL)
     {
@@ -66,10 +228,10 @@ Status open_files(EncodeInfo *encInfo)
     	fprintf(stderr, "ERROR ❌ : Unable to open file %s\n", encInfo->secret_fname);
     	return e_failure;
     }
-    printf("INFO 📂 : Opened secret.txt ✅\n");
+    INFO_PRINTF("INFO 📂 : Opened secret.txt ✅\n");
 
-    // Stego Image file
-    encInfo->fptr_stego_image = fopen(encInfo->stego_image_fname, "w");
+    // Stego Image file, also readable when it gets mapped
+    encInfo->fptr_stego_image = stego_fopen(encInfo->stego_image_fname, encInfo->use_mmap ? "w+" : "w");
     // Do Error handling
     if (encInfo->fptr_stego_image == NULL)
     {
@@ -77,9 +239,108 @@ Status open_files(EncodeInfo *encInfo)
     	fprintf(stderr, "ERROR ❌ : Unable to open file %s\n", encInfo->stego_image_fname);
     	return e_failure;
     }
-    printf("INFO 📂 : Opened stego.bmp ✅\n");
+    INFO_PRINTF("INFO 📂 : Opened stego.bmp ✅\n");
+
+#ifdef __linux__
+    // Start the stego image as a copy of the cover, encoding then only rewrites the pixels it touches
+    if (!is_stdio_fname(encInfo->src_image_fname) && !is_stdio_fname(encInfo->stego_image_fname))
+        encInfo->cloned = clone_cover(encInfo) == e_success;
+#endif
+
+    if (encInfo->use_mmap && map_files(encInfo) == e_failure)
+    {
+    	fprintf(stderr, "ERROR ❌ : Unable to map files for --mmap mode\n");
+    	return e_failure;
+    }
 
-    printf("INFO ℹ️  : All files opened 🎉\n");
+    INFO_PRINTF("INFO ℹ️  : All files opened 🎉\n");
     // No failure return e_success
     return e_success;
 }
+
+/*
+ * Map files for --mmap mode
+ * Inputs: Opened src image, secret and stego image files
+ * Output: src image and secret mapped read-only, stego image
+ * sized like the src image and mapped read-write, holding a
+ * copy of the src image ready to be embedded in place
+ * Return Value: e_success or e_failure, on mapping errors
+ */
+Status map_files(EncodeInfo *encInfo)
+{
+    struct stat st;
+
+    // Src Image file
+    if (fstat(fileno(encInfo->fptr_src_image), &st) != 0 || st.st_size < encInfo->bmp.pixel_offset)
+    	return e_failure;
+    encInfo->image_size = st.st_size;
+    encInfo->src_map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(encInfo->fptr_src_image), 0);
+    if (encInfo->src_map == MAP_FAILED)
+    {
+    	encInfo->src_map = NULL;
+    	perror("mmap ");
+    	return e_failure;
+    }
+
+    // Secret file, an empty one has nothing to map
+    if (fstat(fileno(encInfo->fptr_secret), &st) != 0)
+    	return e_failure;
+    encInfo->size_secret_file = encInfo->plain_size = st.st_size;
+    // Framed secrets are read through the stream, container files one by one
+    if (st.st_size > 0 && !(encInfo->flags & (STEGO_FLAG_FRAMED | STEGO_FLAG_CONTAINER)))
+    {
+    	encInfo->secret_map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(encInfo->fptr_secret), 0);
+    	if (encInfo->secret_map == MAP_FAILED)
+    	{
+    	    encInfo->secret_map = NULL;
+    	    perror("mmap ");
+    	    return e_failure;
+    	}
+    }
+
+    // Stego Image file, a clone of the cover is already the right size
+    if (!encInfo->cloned && ftruncate(fileno(encInfo->fptr_stego_image), encInfo->image_size) != 0)
+    {
+    	perror("ftruncate ");
+    	return e_failure;
+    }
+    encInfo->stego_map = mmap(NULL, encInfo->image_size, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(encInfo->fptr_stego_image), 0);
+    if (encInfo->stego_map == MAP_FAILED)
+    {
+    	encInfo->stego_map = NULL;
+    	perror("mmap ");
+    	return e_failure;
+    }
+
+    // Header and untouched pixels come straight from the cover, unless it was cloned
+    // Pages of zeros are left as holes, the stego image was just extended with zeros
+    if (!encInfo->cloned)
+        copy_sparse(encInfo->stego_map, encInfo->src_map, encInfo->image_size);
+    encInfo->map_pos = 0;
+
+    return e_success;
+}
+
+/* Release the mappings, safe to call when nothing is mapped */
+Status unmap_files(EncodeInfo *encInfo)
+{
+    if (encInfo->stego_map != NULL)
+    {
+    	munmap(encInfo->stego_map, encInfo->image_size);
+    	encInfo->stego_map = NULL;
+    }
+
+    if (encInfo->secret_map != NULL)
+    {
+    	munmap(encInfo->secret_map, encInfo->plain_size);
+    	encInfo->secret_map = NULL;
+    }
+
+    if (encInfo->src_map != NULL)
+    {
+    	munmap(encInfo->src_map, encInfo->image_size);
+    	encInfo->src_map = NULL;
+    }
+
+    return e_success;
+}
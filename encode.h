@@ -2,6 +2,13 @@
 #define ENCODE_H
 
 #include "types.h" // Contains user defined types
+#include "lsb.h"
+#include "common.h"
+#include "bmp.h"
+#include "container.h"
+#include "aead.h"
+#include "scatter.h"
+#include "fec.h"
 
 /* 
  * Structure to store information required for
@@ -14,12 +21,33 @@
 #define MAX_IMAGE_BUF_SIZE (MAX_SECRET_BUF_SIZE * 8)
 #define MAX_FILE_SUFFIX 4
 
+/* Cover bytes read, embedded and written per block (override with -DENC_BLOCK_SIZE=...) */
+#ifndef ENC_BLOCK_SIZE
+#define ENC_BLOCK_SIZE (1 << 20)
+#endif
+
+/* Secret bytes embedded per block, a multiple of LSB_ALIGN that fits a cover block at any depth */
+#define ENC_CHUNK_SIZE (ENC_BLOCK_SIZE / 8 / LSB_ALIGN * LSB_ALIGN)
+
+/* Sealed records embedded per block, whole records only (--passphrase) */
+#define ENC_SEALED_CHUNK (ENC_CHUNK_SIZE / AEAD_RECORD * AEAD_RECORD)
+
+/* Scratch arena : one cover block plus the payload bytes it can hold */
+#define ENC_ARENA_SIZE (ENC_BLOCK_SIZE + ENC_CHUNK_SIZE)
+
+/* Arenas in flight in the streamed encode pipeline (override with -DENC_PIPE_BUFFERS=...) */
+#ifndef ENC_PIPE_BUFFERS
+#define ENC_PIPE_BUFFERS 4
+#endif
+
 typedef struct _EncodeInfo
 {
     /* Source Image info */
     char *src_image_fname;
     FILE *fptr_src_image;
-    uint image_capacity;
+    char bmp_header[BMP_MAX_HEADER_SIZE];
+    BmpInfo bmp;
+    long image_capacity;
     //uint bits_per_pixel;
     //char image_data[MAX_IMAGE_BUF_SIZE];
 
@@ -35,6 +63,68 @@ typedef struct _EncodeInfo
     char *stego_image_fname;
     FILE *fptr_stego_image;
 
+    /* Memory mapped mode (--mmap) */
+    int use_mmap;
+    char *src_map;
+    char *secret_map;
+    char *stego_map;
+    long image_size;
+    long map_pos;
+
+    /* Stego image started as a copy of the whole cover (FICLONE / copy_file_range), only the touched pixels are written */
+    int cloned;
+
+    /* Reusable scratch buffer and its size, see enc_arena() */
+    char *arena;
+    size_t arena_size;
+
+    /* Streamed encode may overlap its I/O on threads of its own, batch workers run it in turn */
+    int pipelined;
+
+    /* Threads embedding the secret data (-j N) */
+    int threads;
+
+    /* LSBs used per cover byte after the stego header (--depth N) */
+    int depth;
+
+    /* STEGO_FLAG_* bits written to the stego header */
+    int flags;
+
+    /* Cover bytes needed so far, checked against image_capacity */
+    long cover_used;
+
+    /* CRC-32C of the secret data (STEGO_FLAG_CRC), built while it is embedded */
+    uint crc;
+
+    /* --passphrase : key the secret is sealed with (STEGO_FLAG_ENCRYPTED) */
+    const char *passphrase;
+    AeadKey key;
+
+    /* Secret bytes before sealing, size_secret_file is what gets embedded */
+    long plain_size;
+
+    /* Framed records sealed so far */
+    long records;
+
+    /* --scatter : key phrase for STEGO_FLAG_SCATTER, and the permutation once the scattered region starts */
+    const char *scatter_key;
+    Scatter scatter;
+
+    /* --fec N : parity bytes per codeword for STEGO_FLAG_FEC, and the blocks once the FEC header is stored */
+    int fec_parity;
+    Fec fec;
+
+    /* map_pos is a carrier offset, or a virtual offset into the scattered cells or the FEC blocks */
+    Remap remapped;
+
+    /* Stego header version stored, STEGO_VERSION_CONTIGUOUS when a piped cover with gaps keeps the old layout */
+    int version;
+
+    /* Files packed into a container payload (--add), the secret file first */
+    char **container_files;
+    int container_count;
+    Container container;
+
 } EncodeInfo;
 
 
@@ -52,32 +142,62 @@ Status do_encoding(EncodeInfo *encInfo);
 /* Get File pointers for i/p and o/p files */
 Status open_files(EncodeInfo *encInfo);
 
+/* Map cover, secret and stego image for --mmap mode */
+Status map_files(EncodeInfo *encInfo);
+
+/* Release the mappings made by map_files */
+Status unmap_files(EncodeInfo *encInfo);
+
 /* check capacity */
 Status check_capacity(EncodeInfo *encInfo);
 
-/* Get image size */
-uint get_image_size_for_bmp(FILE *fptr_image);
+/* Get image size from the BMP header */
+long get_image_size_for_bmp(const char *bmp_header);
 
 /* Get file size */
-uint get_file_size(FILE *fptr);
+long get_file_size(FILE *fptr);
 
 /* Copy bmp image header */
-Status copy_bmp_header(FILE *fptr_src_image, FILE *fptr_dest_image);
+Status copy_bmp_header(const char *bmp_header, uint header_size, FILE *fptr_dest_image);
 
 /* Store Magic String */
 Status encode_magic_string(const char *magic_string, EncodeInfo *encInfo);
 
+/* Store stego header : version and LSB depth */
+Status encode_stego_header(EncodeInfo *encInfo);
+
 /* Encode secret file extenstion */
 Status encode_secret_file_extn(const char *file_extn, EncodeInfo *encInfo);
 
 /* Encode secret file size */
-Status encode_secret_file_size(int file_size, EncodeInfo *encInfo);
+Status encode_secret_file_size(long file_size, EncodeInfo *encInfo);
+
+/* Derive the key for --passphrase and store the crypto header */
+Status encode_crypt_header(EncodeInfo *encInfo);
+
+/* Key the scatter permutation over the pixels after the size field, from here on data is scattered */
+Status encode_scatter_region(EncodeInfo *encInfo);
+
+/* Repeat the magic string and stego header, store the FEC header and lay the FEC blocks over the rest of the pixels */
+Status encode_fec_header(EncodeInfo *encInfo);
+
+/* Add the parity of every FEC block the stego stream reaches */
+Status encode_fec_parity(EncodeInfo *encInfo);
+
+/* Get the reusable scratch arena */
+char *enc_arena(EncodeInfo *encInfo);
+
+/* Get the scratch arena grown to at least size bytes, kept at that size for the next stages and jobs */
+char *enc_arena_reserve(EncodeInfo *encInfo, size_t size);
 
 /* Encode secret file data*/
 Status encode_secret_file_data(EncodeInfo *encInfo);
 
+/* Store the checksum trailer after the secret data */
+Status encode_secret_file_crc(uint crc, EncodeInfo *encInfo);
+
 /* Encode function, which does the real encoding */
-Status encode_data_to_image(const char *data, int size, FILE *fptr_src_image, FILE *fptr_stego_image);
+Status encode_data_to_image(const char *data, long size, int depth, EncodeInfo *encInfo);
 
 /* Encode a byte into LSB of image data array */
 Status encode_byte_to_lsb(char data, char *image_buffer);
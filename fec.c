@@ -0,0 +1,544 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "fec.h"
+#include "lsb.h"
+#include "crc32c.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FEC_X86 1
+#include <immintrin.h>
+#endif
+
+/* x^8 + x^4 + x^3 + x^2 + 1, alpha = 2 */
+#define FEC_POLY 0x11D
+
+/* 16 byte vectors per block row */
+#define FEC_LANES (FEC_INTERLEAVE / 16)
+
+static unsigned char gf_exp[2 * FEC_N];
+static unsigned char gf_log[256];
+static pthread_once_t gf_once = PTHREAD_ONCE_INIT;
+
+static void gf_init(void)
+{
+    int i, x = 1;
+
+    for (i = 0; i < FEC_N; i++)
+    {
+        gf_exp[i] = gf_exp[i + FEC_N] = x;
+        gf_log[x] = i;
+        x <<= 1;
+        if (x & 0x100)
+            x ^= FEC_POLY;
+    }
+}
+
+static inline unsigned char gf_mul(unsigned char a, unsigned char b)
+{
+    return a && b ? gf_exp[gf_log[a] + gf_log[b]] : 0;
+}
+
+static inline unsigned char gf_div(unsigned char a, unsigned char b)
+{
+    return a ? gf_exp[gf_log[a] + FEC_N - gf_log[b]] : 0;
+}
+
+// Product by the constant of a nibble table
+static inline unsigned char tab_mul(const unsigned char *tab, unsigned char x)
+{
+    return tab[x & 0x0F] ^ tab[16 + (x >> 4)];
+}
+
+static void fill_tab(unsigned char *tab, unsigned char a)
+{
+    int x;
+
+    for (x = 0; x < 16; x++)
+    {
+        tab[x] = gf_mul(a, x);
+        tab[16 + x] = gf_mul(a, x << 4);
+    }
+}
+
+Status fec_code_init(FecCode *code, int nsym)
+{
+    int i, j;
+
+    pthread_once(&gf_once, gf_init);
+    if (nsym < FEC_MIN_PARITY || nsym > FEC_MAX_PARITY)
+        return e_failure;
+
+    memset(code, 0, sizeof(*code));
+    code->nsym = nsym;
+
+    // gen(x) = (x + alpha^0)(x + alpha^1)...(x + alpha^(nsym - 1))
+    code->gen[0] = 1;
+    for (j = 0; j < nsym; j++)
+    {
+        for (i = j + 1; i > 0; i--)
+            code->gen[i] = code->gen[i - 1] ^ gf_mul(code->gen[i], gf_exp[j]);
+        code->gen[0] = gf_mul(code->gen[0], gf_exp[j]);
+    }
+
+    for (i = 0; i < nsym; i++)
+    {
+        fill_tab(code->gen_tab[i], code->gen[i]);
+        fill_tab(code->syn_tab[i], gf_exp[i]);
+    }
+
+    return e_success;
+}
+
+// Systematic encoder, one LFSR per codeword : the parity is the remainder of data * x^nsym by gen
+static void fec_encode_scalar(const FecCode *code, const unsigned char *data, unsigned char *parity)
+{
+    unsigned char reg[FEC_MAX_PARITY], fb;
+    int nsym = code->nsym, k = FEC_N - nsym, c, s, i;
+
+    for (c = 0; c < FEC_INTERLEAVE; c++)
+    {
+        memset(reg, 0, sizeof(reg));
+        for (s = 0; s < k; s++)
+        {
+            fb = data[s * FEC_INTERLEAVE + c] ^ reg[nsym - 1];
+            for (i = nsym - 1; i > 0; i--)
+                reg[i] = reg[i - 1] ^ tab_mul(code->gen_tab[i], fb);
+            reg[0] = tab_mul(code->gen_tab[0], fb);
+        }
+
+        for (i = 0; i < nsym; i++)
+            parity[i * FEC_INTERLEAVE + c] = reg[nsym - 1 - i];
+    }
+}
+
+// syn[j][c] = codeword c evaluated at alpha^j, Horner over its symbols
+static void fec_syndromes_scalar(const FecCode *code, const unsigned char *block, unsigned char syn[][FEC_INTERLEAVE])
+{
+    int s, j, c;
+
+    memset(syn, 0, code->nsym * FEC_INTERLEAVE);
+    for (s = 0; s < FEC_N; s++)
+    {
+        for (j = 0; j < code->nsym; j++)
+        {
+            for (c = 0; c < FEC_INTERLEAVE; c++)
+                syn[j][c] = tab_mul(code->syn_tab[j], syn[j][c]) ^ block[s * FEC_INTERLEAVE + c];
+        }
+    }
+}
+
+#ifdef FEC_X86
+
+// 16 products by the constant of a nibble table, x given as its low and high nibbles
+__attribute__((target("ssse3")))
+static inline __m128i gf_mul_ssse3(__m128i lo, __m128i hi, const unsigned char *tab)
+{
+    return _mm_xor_si128(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)tab), lo),
+                         _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(tab + 16)), hi));
+}
+
+// The scalar encoder on all codewords at once, one block row per step
+__attribute__((target("ssse3")))
+static void fec_encode_ssse3(const FecCode *code, const unsigned char *data, unsigned char *parity)
+{
+    const __m128i nib = _mm_set1_epi8(0x0F);
+    __m128i reg[FEC_MAX_PARITY][FEC_LANES], fb, lo, hi;
+    int nsym = code->nsym, k = FEC_N - nsym, s, i, v;
+
+    memset(reg, 0, sizeof(reg));
+    for (s = 0; s < k; s++)
+    {
+        for (v = 0; v < FEC_LANES; v++)
+        {
+            fb = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(data + s * FEC_INTERLEAVE + v * 16)), reg[nsym - 1][v]);
+            lo = _mm_and_si128(fb, nib);
+            hi = _mm_and_si128(_mm_srli_epi64(fb, 4), nib);
+            for (i = nsym - 1; i > 0; i--)
+                reg[i][v] = _mm_xor_si128(reg[i - 1][v], gf_mul_ssse3(lo, hi, code->gen_tab[i]));
+            reg[0][v] = gf_mul_ssse3(lo, hi, code->gen_tab[0]);
+        }
+    }
+
+    for (i = 0; i < nsym; i++)
+    {
+        for (v = 0; v < FEC_LANES; v++)
+            _mm_storeu_si128((__m128i *)(parity + i * FEC_INTERLEAVE + v * 16), reg[nsym - 1 - i][v]);
+    }
+}
+
+__attribute__((target("ssse3")))
+static void fec_syndromes_ssse3(const FecCode *code, const unsigned char *block, unsigned char syn[][FEC_INTERLEAVE])
+{
+    const __m128i nib = _mm_set1_epi8(0x0F);
+    __m128i acc[FEC_MAX_PARITY][FEC_LANES], x;
+    int nsym = code->nsym, s, j, v;
+
+    memset(acc, 0, sizeof(acc));
+    for (s = 0; s < FEC_N; s++)
+    {
+        for (v = 0; v < FEC_LANES; v++)
+        {
+            x = _mm_loadu_si128((const __m128i *)(block + s * FEC_INTERLEAVE + v * 16));
+            for (j = 0; j < nsym; j++)
+                acc[j][v] = _mm_xor_si128(gf_mul_ssse3(_mm_and_si128(acc[j][v], nib),
+                                                       _mm_and_si128(_mm_srli_epi64(acc[j][v], 4), nib),
+                                                       code->syn_tab[j]), x);
+        }
+    }
+
+    for (j = 0; j < nsym; j++)
+    {
+        for (v = 0; v < FEC_LANES; v++)
+            _mm_storeu_si128((__m128i *)(syn[j] + v * 16), acc[j][v]);
+    }
+}
+
+#endif
+
+void fec_encode(const FecCode *code, const unsigned char *data, unsigned char *parity)
+{
+#ifdef FEC_X86
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        fec_encode_ssse3(code, data, parity);
+        return;
+    }
+#endif
+    fec_encode_scalar(code, data, parity);
+}
+
+static void fec_syndromes(const FecCode *code, const unsigned char *block, unsigned char syn[][FEC_INTERLEAVE])
+{
+#ifdef FEC_X86
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        fec_syndromes_ssse3(code, block, syn);
+        return;
+    }
+#endif
+    fec_syndromes_scalar(code, block, syn);
+}
+
+// Repair codeword c of a block from its syndromes syn[0..nsym), returns the symbols repaired or -1
+// Berlekamp-Massey for the error locator, Chien search for the damaged symbols, Forney for their values
+static int fec_correct(const FecCode *code, unsigned char *block, int c, const unsigned char *syn)
+{
+    unsigned char lambda[FEC_MAX_PARITY + 1], prev[FEC_MAX_PARITY + 1], old[FEC_MAX_PARITY + 1];
+    unsigned char omega[FEC_MAX_PARITY], value[FEC_MAX_PARITY], b = 1, d, coef, x, num, den;
+    int nsym = code->nsym, len = 0, m = 1, n, i, j, s, count = 0, where[FEC_MAX_PARITY];
+
+    memset(lambda, 0, sizeof(lambda));
+    memset(prev, 0, sizeof(prev));
+    lambda[0] = prev[0] = 1;
+
+    for (n = 0; n < nsym; n++)
+    {
+        d = syn[n];
+        for (i = 1; i <= len; i++)
+            d ^= gf_mul(lambda[i], syn[n - i]);
+        if (d == 0)
+        {
+            m++;
+            continue;
+        }
+
+        coef = gf_div(d, b);
+        memcpy(old, lambda, sizeof(old));
+        for (i = 0; i + m <= nsym; i++)
+            lambda[i + m] ^= gf_mul(coef, prev[i]);
+
+        if (2 * len <= n)
+        {
+            len = n + 1 - len;
+            memcpy(prev, old, sizeof(prev));
+            b = d;
+            m = 1;
+        }
+        else
+            m++;
+    }
+    if (2 * len > nsym)
+        return -1;
+
+    // omega = syndromes * lambda mod x^nsym
+    for (i = 0; i < nsym; i++)
+    {
+        omega[i] = 0;
+        for (j = 0; j <= i && j <= len; j++)
+            omega[i] ^= gf_mul(lambda[j], syn[i - j]);
+    }
+
+    // Symbol s has locator X = alpha^(FEC_N - 1 - s), it is damaged when lambda(1 / X) is 0
+    for (s = 0; s < FEC_N; s++)
+    {
+        x = gf_exp[(s + 1) % FEC_N];
+
+        for (d = 0, i = len; i >= 0; i--)
+            d = gf_mul(d, x) ^ lambda[i];
+        if (d != 0)
+            continue;
+
+        // Forney : value = X * omega(1 / X) / lambda'(1 / X)
+        for (num = 0, i = nsym - 1; i >= 0; i--)
+            num = gf_mul(num, x) ^ omega[i];
+        for (den = 0, i = len - (len % 2 == 0); i >= 1; i -= 2)
+            den = gf_mul(den, gf_mul(x, x)) ^ lambda[i];
+        if (den == 0 || count == FEC_MAX_PARITY)
+            return -1;
+
+        where[count] = s;
+        value[count++] = gf_mul(gf_exp[FEC_N - 1 - s], gf_div(num, den));
+    }
+
+    // Every root has to be a symbol of the codeword
+    if (count != len)
+        return -1;
+
+    for (i = 0; i < count; i++)
+        block[where[i] * FEC_INTERLEAVE + c] ^= value[i];
+    return count;
+}
+
+int fec_decode(const FecCode *code, unsigned char *block, int *failed)
+{
+    unsigned char syn[FEC_MAX_PARITY][FEC_INTERLEAVE], lane[FEC_MAX_PARITY], any;
+    int c, j, n, fixed = 0;
+
+    fec_syndromes(code, block, syn);
+
+    *failed = 0;
+    for (c = 0; c < FEC_INTERLEAVE; c++)
+    {
+        for (any = 0, j = 0; j < code->nsym; j++)
+            any |= lane[j] = syn[j][c];
+        if (any == 0)
+            continue;
+
+        n = fec_correct(code, block, c, lane);
+        if (n < 0)
+            (*failed)++;
+        else
+            fixed += n;
+    }
+
+    return fixed;
+}
+
+Status fec_init(Fec *fec, int nsym, int depth, long base, long size, const BmpInfo *bmp)
+{
+    if (fec_code_init(&fec->code, nsym) == e_failure)
+        return e_failure;
+
+    fec->base = base;
+    fec->bmp = bmp;
+    fec->depth = depth;
+    fec->data_cover = LSB_COVER_SIZE((long)FEC_PAYLOAD(nsym), depth);
+    fec->block_cover = LSB_COVER_SIZE((long)FEC_BLOCK, depth);
+    fec->blocks = size > 0 ? size / fec->block_cover : 0;
+    fec->filled = NULL;
+
+    return fec->blocks > 0 ? e_success : e_failure;
+}
+
+Status fec_track(Fec *fec)
+{
+    fec->filled = calloc(fec->blocks, sizeof(*fec->filled));
+    return fec->filled != NULL ? e_success : e_failure;
+}
+
+void fec_free(Fec *fec)
+{
+    free(fec->filled);
+    fec->filled = NULL;
+}
+
+// CRC-32C of the stego bytes of a block, as stored in its FEC_CHECK bytes
+static uint block_crc(const unsigned char *block, int payload)
+{
+    return crc32c(0, block, payload);
+}
+
+static uint stored_crc(const unsigned char *check)
+{
+    return (uint)check[0] << 24 | (uint)check[1] << 16 | (uint)check[2] << 8 | check[3];
+}
+
+long fec_end(const Fec *fec)
+{
+    return fec->base + fec->blocks * fec->data_cover;
+}
+
+long fec_capacity(int nsym, int depth, long size)
+{
+    return size > 0 ? size / LSB_COVER_SIZE((long)FEC_BLOCK, depth) * LSB_COVER_SIZE((long)FEC_PAYLOAD(nsym), depth) : 0;
+}
+
+long fec_blocks_used(const Fec *fec, long end)
+{
+    return (end - fec->base + fec->data_cover - 1) / fec->data_cover;
+}
+
+void fec_gather(const Fec *fec, const char *map, long pos, long n, char *buf, FecStats *stats)
+{
+    unsigned char block[FEC_BLOCK], raw[FEC_BLOCK];
+    long b = (pos - fec->base) / fec->data_cover, off = (pos - fec->base) % fec->data_cover, len, i, at;
+    int depth = fec->depth, data = FEC_DATA(fec->code.nsym), payload = FEC_PAYLOAD(fec->code.nsym), fixed, failed;
+    const char *cover;
+    char *repaired = NULL, *gathered = NULL;
+
+    for (; n > 0; b++, off = 0, buf += len, n -= len)
+    {
+        len = fec->data_cover - off < n ? fec->data_cover - off : n;
+        at = fec->base + b * fec->block_cover;
+
+        // Blocks over colour bytes are gathered whole to be checked, or only the span asked for
+        if (fec->bmp != NULL && stats != NULL && (gathered != NULL || (gathered = malloc(fec->block_cover)) != NULL))
+        {
+            bmp_gather(fec->bmp, map, at, fec->block_cover, gathered);
+            cover = gathered;
+        }
+        else if (fec->bmp != NULL)
+        {
+            bmp_gather(fec->bmp, map, at + off, len, buf);
+            continue;
+        }
+        else
+            cover = map + at;
+
+        if (stats == NULL)
+        {
+            memcpy(buf, cover + off, len);
+            continue;
+        }
+
+        // Clean blocks, nearly all of them, match their checksum and are passed through without the syndromes
+        lsb_extract((char *)block, data, cover, depth);
+        if (block_crc(block, payload) == stored_crc(block + payload))
+        {
+            memcpy(buf, cover + off, len);
+            continue;
+        }
+
+        lsb_extract((char *)block + data, FEC_BLOCK - data, cover + LSB_COVER_SIZE((long)data, depth), depth);
+        fixed = fec_decode(&fec->code, block, &failed);
+        if (failed > 0)
+            __atomic_add_fetch(&stats->failed, failed, __ATOMIC_RELAXED);
+        if (fixed == 0 || (repaired == NULL && (repaired = malloc(fec->data_cover)) == NULL))
+        {
+            memcpy(buf, cover + off, len);
+            continue;
+        }
+
+        // Count the repaired data bytes that start inside the span asked for, the map still has them damaged
+        lsb_extract((char *)raw, payload, cover, depth);
+        for (fixed = 0, i = 0; i < payload; i++)
+            fixed += raw[i] != block[i] && i * 8 / depth >= off && i * 8 / depth < off + len;
+        __atomic_add_fetch(&stats->fixed, fixed, __ATOMIC_RELAXED);
+
+        // Embed the repaired data into a copy of the cover bytes
+        memcpy(repaired, cover, fec->data_cover);
+        lsb_embed((char *)block, payload, repaired, depth);
+        memcpy(buf, repaired + off, len);
+    }
+
+    free(repaired);
+    free(gathered);
+}
+
+int fec_vote(const unsigned char *copies, int size, int max_dist, unsigned char *vote)
+{
+    const unsigned char *a = copies, *b = copies + size, *c = copies + 2 * size;
+    int i, ab = 0, ac = 0, bc = 0, outvoted = 0;
+
+    for (i = 0; i < size; i++)
+    {
+        vote[i] = (a[i] & b[i]) | (a[i] & c[i]) | (b[i] & c[i]);
+        ab += __builtin_popcount(a[i] ^ b[i]);
+        ac += __builtin_popcount(a[i] ^ c[i]);
+        bc += __builtin_popcount(b[i] ^ c[i]);
+        outvoted += (a[i] != vote[i]) + (b[i] != vote[i]) + (c[i] != vote[i]);
+    }
+
+    // One pair close enough carries the vote, otherwise these are unrelated bytes
+    if (ab > max_dist && ac > max_dist && bc > max_dist)
+        return -1;
+    return outvoted;
+}
+
+// Work out and embed the checksum and parity of blocks [first, last), skipping the sealed ones when skip_sealed is set
+static Status seal_blocks(const Fec *fec, char *map, long first, long last, int skip_sealed)
+{
+    unsigned char block[FEC_BLOCK];
+    int data = FEC_DATA(fec->code.nsym), payload = FEC_PAYLOAD(fec->code.nsym);
+    uint crc;
+    long at;
+    char *cover, *gathered = NULL;
+
+    // Blocks over colour bytes are gathered, and only their checksum and parity put back
+    if (fec->bmp != NULL && (gathered = malloc(fec->block_cover)) == NULL)
+        return e_failure;
+
+    for (; first < last; first++)
+    {
+        if (skip_sealed && fec->filled != NULL && fec->filled[first] == fec->data_cover)
+            continue;
+
+        at = fec->base + first * fec->block_cover;
+        cover = map + at;
+        if (gathered != NULL)
+        {
+            bmp_gather(fec->bmp, map, at, fec->block_cover, gathered);
+            cover = gathered;
+        }
+
+        lsb_extract((char *)block, payload, cover, fec->depth);
+        crc = block_crc(block, payload);
+        memset(block + payload, 0, FEC_CHECK);
+        block[payload] = (crc >> 24) & 0xFF;
+        block[payload + 1] = (crc >> 16) & 0xFF;
+        block[payload + 2] = (crc >> 8) & 0xFF;
+        block[payload + 3] = crc & 0xFF;
+
+        fec_encode(&fec->code, block, block + data);
+        lsb_embed((char *)block + payload, FEC_BLOCK - payload, cover + fec->data_cover, fec->depth);
+
+        if (gathered != NULL)
+            bmp_put(fec->bmp, map, at + fec->data_cover, fec->block_cover - fec->data_cover, gathered + fec->data_cover);
+    }
+
+    free(gathered);
+    return e_success;
+}
+
+void fec_put(Fec *fec, char *map, long pos, long n, const char *buf)
+{
+    long b = (pos - fec->base) / fec->data_cover, off = (pos - fec->base) % fec->data_cover, len;
+
+    for (; n > 0; b++, off = 0, buf += len, n -= len)
+    {
+        len = fec->data_cover - off < n ? fec->data_cover - off : n;
+        if (fec->bmp != NULL)
+            bmp_put(fec->bmp, map, fec->base + b * fec->block_cover + off, len, buf);
+        else
+            memcpy(map + fec->base + b * fec->block_cover + off, buf, len);
+
+        // The put that completes a block seals it, its stego bytes are still in the cache. Stripes
+        // fill blocks in any order and share the ones at their edges, the count tells when one is whole
+        if (fec->filled != NULL && __atomic_add_fetch(&fec->filled[b], len, __ATOMIC_ACQ_REL) == fec->data_cover &&
+            seal_blocks(fec, map, b, b + 1, 0) == e_failure)
+            __atomic_store_n(&fec->filled[b], 0, __ATOMIC_RELEASE);
+    }
+}
+
+Status fec_seal(const Fec *fec, char *map, long first, long last)
+{
+    return seal_blocks(fec, map, first, last, 1);
+}
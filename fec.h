@@ -0,0 +1,149 @@
+#ifndef FEC_H
+#define FEC_H
+
+#include "types.h"
+#include "bmp.h"
+
+/*
+ * Reed-Solomon forward error correction (STEGO_FLAG_FEC, --fec N)
+ * Everything after the stego header and the FEC header is cut into blocks of
+ * FEC_INTERLEAVE interleaved RS(255, 255 - N) codewords over GF(2^8), N parity
+ * bytes each. A block holds FEC_DATA(N) data bytes followed by the N * FEC_INTERLEAVE
+ * parity bytes, byte s * FEC_INTERLEAVE + c being symbol s of codeword c, so
+ * a run of damaged bytes is shared out over the codewords. Each codeword
+ * repairs up to N / 2 damaged bytes. The data part is FEC_PAYLOAD(N) stego
+ * bytes and FEC_CHECK bytes starting with their CRC-32C, big endian.
+ *
+ * The stego bytes of the blocks are laid out back to back at virtual stego
+ * offsets, like scatter.h does with its cells : data offset i maps to its cover
+ * bytes in constant time. A block's checksum and parity are added as soon as
+ * its stego bytes are all embedded (fec_track()). Blocks are checked as their
+ * cover bytes are gathered : one whose checksum matches is passed through, the
+ * others go through the RS syndromes and are repaired. GF(2^8) products by the
+ * code constants use PSHUFB nibble tables on SSSE3 CPUs.
+ *
+ * FEC images store the magic string and stego header STEGO_FEC_COPIES times
+ * in a row at 1 LSB per byte, and the FEC header after the last copy : the
+ * parity count stored STEGO_FEC_HEADER_SIZE times. Both are read by bitwise
+ * majority vote (fec_vote()), so damage to one copy is outvoted
+ */
+
+/* Symbols per codeword */
+#define FEC_N 255
+
+/* Codewords per block, a multiple of 16 (SSE lanes) and of LSB_ALIGN */
+#define FEC_INTERLEAVE 48
+
+/* Parity bytes per codeword for --fec */
+#define FEC_MIN_PARITY 2
+#define FEC_MAX_PARITY 64
+
+/* Bytes of a block, and its data bytes for nsym parity bytes per codeword */
+#define FEC_BLOCK (FEC_N * FEC_INTERLEAVE)
+#define FEC_DATA(nsym) ((FEC_N - (nsym)) * FEC_INTERLEAVE)
+
+/* Block checksum at the end of the data part, a CRC-32C padded to LSB_ALIGN bytes so the parity starts on a whole cover byte */
+#define FEC_CHECK 12
+
+/* Stego bytes of a block, its data part less the checksum */
+#define FEC_PAYLOAD(nsym) (FEC_DATA(nsym) - FEC_CHECK)
+
+typedef struct
+{
+    int nsym;
+
+    /* Generator polynomial, lowest degree first, gen[nsym] is 1 */
+    unsigned char gen[FEC_MAX_PARITY + 1];
+
+    /* Products by gen[i] and by alpha^i : 16 entries for the low nibble, 16 for the high one */
+    unsigned char gen_tab[FEC_MAX_PARITY][32];
+    unsigned char syn_tab[FEC_MAX_PARITY][32];
+} FecCode;
+
+/* Repairs made while gathering, updated atomically by every stripe */
+typedef struct
+{
+    long fixed;
+    long failed;
+} FecStats;
+
+typedef struct
+{
+    FecCode code;
+
+    /* First cover byte of the region, virtual offsets start here too */
+    long base;
+
+    /* Whole blocks in the region */
+    long blocks;
+
+    int depth;
+
+    /* Cover bytes of the stego bytes of a block, and of the whole block */
+    long data_cover;
+    long block_cover;
+
+    /* Colour bytes the blocks are laid over when offsets are carrier offsets (bmp.h), NULL for file offsets */
+    const BmpInfo *bmp;
+
+    /*
+     * Encoding : cover bytes fec_put() has filled in each block, it seals a block once they reach
+     * data_cover. A block whose seal failed is set back to 0 for fec_seal() to retry. NULL decoding
+     */
+    long *filled;
+} Fec;
+
+/* Code with nsym parity bytes per codeword, e_failure outside FEC_MIN_PARITY..FEC_MAX_PARITY */
+Status fec_code_init(FecCode *code, int nsym);
+
+/* Parity of a block : FEC_DATA(nsym) data bytes in, nsym * FEC_INTERLEAVE parity bytes out */
+void fec_encode(const FecCode *code, const unsigned char *data, unsigned char *parity);
+
+/*
+ * Check a block (data then parity) and repair it in place
+ * Returns the bytes repaired, *failed gets the codewords with more damage than they can repair
+ */
+int fec_decode(const FecCode *code, unsigned char *block, int *failed);
+
+/* Region of whole blocks at depth in the size cover bytes from base */
+Status fec_init(Fec *fec, int nsym, int depth, long base, long size, const BmpInfo *bmp);
+
+/* Have fec_put() seal every block as its stego bytes are all put in, e_failure without memory */
+Status fec_track(Fec *fec);
+
+/* Release what fec_track() allocated */
+void fec_free(Fec *fec);
+
+/* End of the virtual offsets, base plus the data part of every block */
+long fec_end(const Fec *fec);
+
+/* Cover bytes left for data in size cover bytes at depth, the stego bytes of the whole blocks */
+long fec_capacity(int nsym, int depth, long size);
+
+/* Blocks the virtual offsets up to end reach into */
+long fec_blocks_used(const Fec *fec, long end);
+
+/*
+ * Copy n cover bytes at virtual offset pos out of map into buf, repairing the blocks they are in
+ * when their checksum doesn't match and counting the repairs in stats. stats NULL copies the
+ * bytes as they are (encoding)
+ */
+void fec_gather(const Fec *fec, const char *map, long pos, long n, char *buf, FecStats *stats);
+
+/*
+ * Bitwise majority of the three size byte copies stored back to back in copies
+ * Returns the copy bytes outvoted, -1 when every two copies differ in more than
+ * max_dist bits (the bytes aren't copies of one another)
+ */
+int fec_vote(const unsigned char *copies, int size, int max_dist, unsigned char *vote);
+
+/* Copy n bytes of buf back to virtual offset pos of map, sealing the blocks this fills up when tracked */
+void fec_put(Fec *fec, char *map, long pos, long n, const char *buf);
+
+/*
+ * Work out and embed the checksum and parity of blocks [first, last), skipping the ones fec_put()
+ * already sealed. e_failure if the colour bytes of a block can't be gathered
+ */
+Status fec_seal(const Fec *fec, char *map, long first, long last);
+
+#endif
@@ -0,0 +1,541 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project
+*/
+
+#include <string.h>
+#include "lsb.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LSB_X86 1
+#include <immintrin.h>
+#endif
+
+// Scalar embed, one payload bit per cover byte, MSB first
+static void lsb_embed_scalar(const unsigned char *data, size_t size, unsigned char *image_buffer)
+{
+    size_t i;
+    int j;
+
+    for (i = 0; i < size; i++)
+    {
+        for (j = 0; j < 8; j++)
+        {
+            image_buffer[j] = (image_buffer[j] & ~1) | ((data[i] >> (7 - j)) & 1);
+        }
+        image_buffer += 8;
+    }
+}
+
+// Scalar extract, collects 8 LSBs back into one byte, MSB first
+static void lsb_extract_scalar(unsigned char *data, size_t size, const unsigned char *image_buffer)
+{
+    size_t i;
+    int j;
+
+    for (i = 0; i < size; i++)
+    {
+        unsigned char ch = 0;
+        for (j = 0; j < 8; j++)
+        {
+            ch = (ch << 1) | (image_buffer[j] & 1);
+        }
+        data[i] = ch;
+        image_buffer += 8;
+    }
+}
+
+// Scalar embed of a partial group at depth 2..4, payload bits are fed through a small bit accumulator
+static void lsb_embed_tail(const unsigned char *data, size_t size, unsigned char *image_buffer, int depth)
+{
+    unsigned int acc = 0, mask = (1u << depth) - 1;
+    int nbits = 0;
+    size_t i = 0;
+
+    while (i < size || nbits > 0)
+    {
+        if (nbits < depth)
+        {
+            if (i < size)
+            {
+                acc = (acc << 8) | data[i++];
+                nbits += 8;
+            }
+            else
+            {
+                // Pad the last cover byte with zero bits
+                acc <<= depth - nbits;
+                nbits = depth;
+            }
+        }
+
+        nbits -= depth;
+        *image_buffer = (*image_buffer & ~mask) | ((acc >> nbits) & mask);
+        image_buffer++;
+        acc &= (1u << nbits) - 1;
+    }
+}
+
+// Scalar extract of a partial group at depth 2..4
+static void lsb_extract_tail(unsigned char *data, size_t size, const unsigned char *image_buffer, int depth)
+{
+    unsigned int acc = 0, mask = (1u << depth) - 1;
+    int nbits = 0;
+    size_t i = 0;
+
+    while (i < size)
+    {
+        acc = (acc << depth) | (*image_buffer++ & mask);
+        nbits += depth;
+
+        if (nbits >= 8)
+        {
+            nbits -= 8;
+            data[i++] = acc >> nbits;
+            acc &= (1u << nbits) - 1;
+        }
+    }
+}
+
+// Scalar embed for depth 2..4, every depth payload bytes fill 8 cover bytes through one word
+static void lsb_embed_bits(const unsigned char *data, size_t size, unsigned char *image_buffer, int depth)
+{
+    unsigned int group, mask = (1u << depth) - 1;
+    size_t i;
+    int j;
+
+    for (i = 0; i + depth <= size; i += depth)
+    {
+        group = 0;
+        for (j = 0; j < depth; j++)
+            group = (group << 8) | data[i + j];
+
+        for (j = 0; j < 8; j++)
+            image_buffer[j] = (image_buffer[j] & ~mask) | ((group >> (depth * (7 - j))) & mask);
+        image_buffer += 8;
+    }
+
+    lsb_embed_tail(data + i, size - i, image_buffer, depth);
+}
+
+// Scalar extract for depth 2..4, 8 cover bytes give back depth payload bytes
+static void lsb_extract_bits(unsigned char *data, size_t size, const unsigned char *image_buffer, int depth)
+{
+    unsigned int group, mask = (1u << depth) - 1;
+    size_t i;
+    int j;
+
+    for (i = 0; i + depth <= size; i += depth)
+    {
+        group = 0;
+        for (j = 0; j < 8; j++)
+            group = (group << depth) | (image_buffer[j] & mask);
+
+        for (j = depth - 1; j >= 0; j--)
+        {
+            data[i + j] = group & 0xFF;
+            group >>= 8;
+        }
+        image_buffer += 8;
+    }
+
+    lsb_extract_tail(data + i, size - i, image_buffer, depth);
+}
+
+#ifdef LSB_X86
+
+// Replace the LSB of 16 cover bytes with the bits selected by mask from the spread payload bytes
+__attribute__((target("sse2")))
+static inline void lsb_blend_sse2(unsigned char *image_buffer, __m128i spread, __m128i mask)
+{
+    __m128i bit = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(spread, mask), mask), _mm_set1_epi8(1));
+    __m128i img = _mm_loadu_si128((const __m128i *)image_buffer);
+
+    img = _mm_or_si128(_mm_and_si128(img, _mm_set1_epi8((char)0xFE)), bit);
+    _mm_storeu_si128((__m128i *)image_buffer, img);
+}
+
+// SSE2 embed : 16 payload bytes into 128 cover bytes per iteration
+__attribute__((target("sse2")))
+static void lsb_embed_sse2(const unsigned char *data, size_t size, unsigned char *image_buffer)
+{
+    const __m128i mask = _mm_setr_epi8((char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                       (char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+    size_t i;
+
+    for (i = 0; i + 16 <= size; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i lo = _mm_unpacklo_epi8(x, x), hi = _mm_unpackhi_epi8(x, x);
+        __m128i q0 = _mm_unpacklo_epi16(lo, lo), q1 = _mm_unpackhi_epi16(lo, lo);
+        __m128i q2 = _mm_unpacklo_epi16(hi, hi), q3 = _mm_unpackhi_epi16(hi, hi);
+
+        // Each vector now holds two payload bytes repeated 8 times
+        lsb_blend_sse2(image_buffer + 0, _mm_unpacklo_epi32(q0, q0), mask);
+        lsb_blend_sse2(image_buffer + 16, _mm_unpackhi_epi32(q0, q0), mask);
+        lsb_blend_sse2(image_buffer + 32, _mm_unpacklo_epi32(q1, q1), mask);
+        lsb_blend_sse2(image_buffer + 48, _mm_unpackhi_epi32(q1, q1), mask);
+        lsb_blend_sse2(image_buffer + 64, _mm_unpacklo_epi32(q2, q2), mask);
+        lsb_blend_sse2(image_buffer + 80, _mm_unpackhi_epi32(q2, q2), mask);
+        lsb_blend_sse2(image_buffer + 96, _mm_unpacklo_epi32(q3, q3), mask);
+        lsb_blend_sse2(image_buffer + 112, _mm_unpackhi_epi32(q3, q3), mask);
+        image_buffer += 128;
+    }
+
+    lsb_embed_scalar(data + i, size - i, image_buffer);
+}
+
+// SSE2 extract : 2 payload bytes per 16 cover bytes with movemask
+__attribute__((target("sse2")))
+static void lsb_extract_sse2(unsigned char *data, size_t size, const unsigned char *image_buffer)
+{
+    size_t i;
+
+    for (i = 0; i + 2 <= size; i += 2)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)image_buffer);
+        int bits;
+
+        // Reverse the bytes of each 8 byte group so the first cover byte becomes the MSB
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+
+        // Move every LSB to bit 7 of its byte and gather them
+        bits = _mm_movemask_epi8(_mm_slli_epi64(v, 7));
+        data[i] = bits & 0xFF;
+        data[i + 1] = (bits >> 8) & 0xFF;
+        image_buffer += 16;
+    }
+
+    lsb_extract_scalar(data + i, size - i, image_buffer);
+}
+
+// AVX2 embed : 32 payload bytes into 256 cover bytes per iteration
+__attribute__((target("avx2")))
+static void lsb_embed_avx2(const unsigned char *data, size_t size, unsigned char *image_buffer)
+{
+    const __m256i mask = _mm256_setr_epi8((char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                          (char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                          (char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                          (char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+    const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                            2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i keep = _mm256_set1_epi8((char)0xFE);
+    size_t i;
+    int k;
+
+    for (i = 0; i + 32 <= size; i += 32)
+    {
+        for (k = 0; k < 8; k++)
+        {
+            int word;
+            __m256i v, bit, img;
+
+            // Broadcast 4 payload bytes and repeat each one 8 times
+            memcpy(&word, data + i + k * 4, 4);
+            v = _mm256_shuffle_epi8(_mm256_set1_epi32(word), spread);
+            bit = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(v, mask), mask), one);
+
+            img = _mm256_loadu_si256((const __m256i *)image_buffer);
+            img = _mm256_or_si256(_mm256_and_si256(img, keep), bit);
+            _mm256_storeu_si256((__m256i *)image_buffer, img);
+            image_buffer += 32;
+        }
+    }
+
+    lsb_embed_scalar(data + i, size - i, image_buffer);
+}
+
+// AVX2 extract : 4 payload bytes per 32 cover bytes with movemask
+__attribute__((target("avx2")))
+static void lsb_extract_avx2(unsigned char *data, size_t size, const unsigned char *image_buffer)
+{
+    const __m256i reverse = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                             7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    size_t i;
+
+    for (i = 0; i + 4 <= size; i += 4)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)image_buffer);
+        unsigned int bits;
+
+        v = _mm256_shuffle_epi8(v, reverse);
+        bits = (unsigned int)_mm256_movemask_epi8(_mm256_slli_epi64(v, 7));
+        data[i] = bits & 0xFF;
+        data[i + 1] = (bits >> 8) & 0xFF;
+        data[i + 2] = (bits >> 16) & 0xFF;
+        data[i + 3] = (bits >> 24) & 0xFF;
+        image_buffer += 32;
+    }
+
+    lsb_extract_scalar(data + i, size - i, image_buffer);
+}
+
+// pshufb and pmullw tables for depth 2..4 : 16-bit lane j gets the payload byte holding the first
+// bit of cover byte j of the group at base in its high byte, and the next one in its low byte when
+// the bits cross into it. Multiplying by shift[j] puts cover byte j's bits at the top of the lane
+static void lsb_spread_table(unsigned char *shuffle, unsigned short *shift, int base, int depth)
+{
+    int j, bit;
+
+    for (j = 0; j < 8; j++)
+    {
+        bit = j * depth;
+        shuffle[2 * j + 1] = base + bit / 8;
+        shuffle[2 * j] = bit % 8 + depth > 8 ? base + bit / 8 + 1 : 0x80;
+        shift[j] = 1 << (bit % 8);
+    }
+}
+
+// pshufb table taking the depth payload bytes of the two groups out of their 64-bit lanes, MSB first
+static void lsb_gather_table(unsigned char *order, int depth)
+{
+    int j;
+
+    memset(order, 0x80, 16);
+    for (j = 0; j < depth; j++)
+    {
+        order[j] = depth - 1 - j;
+        order[depth + j] = 8 + depth - 1 - j;
+    }
+}
+
+// SSSE3 embed at depth 2..4 : 2 * depth payload bytes into 16 cover bytes per iteration
+__attribute__((target("ssse3")))
+static void lsb_embed_bits_ssse3(const unsigned char *data, size_t size, unsigned char *image_buffer, int depth)
+{
+    unsigned char shuffle[2][16];
+    unsigned short shift[8];
+    __m128i spread_a, spread_b, mul, keep, count;
+    size_t i;
+
+    lsb_spread_table(shuffle[0], shift, 0, depth);
+    lsb_spread_table(shuffle[1], shift, depth, depth);
+    spread_a = _mm_loadu_si128((const __m128i *)shuffle[0]);
+    spread_b = _mm_loadu_si128((const __m128i *)shuffle[1]);
+    mul = _mm_loadu_si128((const __m128i *)shift);
+    keep = _mm_set1_epi8((char)~((1 << depth) - 1));
+    count = _mm_cvtsi32_si128(16 - depth);
+
+    // The load reads 16 payload bytes, only the first 2 * depth are used
+    for (i = 0; i + 16 <= size; i += 2 * depth)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i a = _mm_srl_epi16(_mm_mullo_epi16(_mm_shuffle_epi8(x, spread_a), mul), count);
+        __m128i b = _mm_srl_epi16(_mm_mullo_epi16(_mm_shuffle_epi8(x, spread_b), mul), count);
+        __m128i img = _mm_loadu_si128((const __m128i *)image_buffer);
+
+        img = _mm_or_si128(_mm_and_si128(img, keep), _mm_packus_epi16(a, b));
+        _mm_storeu_si128((__m128i *)image_buffer, img);
+        image_buffer += 16;
+    }
+
+    lsb_embed_bits(data + i, size - i, image_buffer, depth);
+}
+
+// Fold the low depth bits of 16 cover bytes into one 8 * depth bit group per 64-bit lane :
+// pairs of cover bytes, then pairs of those, then the two halves of the lane
+__attribute__((target("ssse3")))
+static inline __m128i lsb_gather_ssse3(__m128i v, __m128i mask, __m128i pair, __m128i quad, __m128i count)
+{
+    __m128i x = _mm_madd_epi16(_mm_maddubs_epi16(_mm_and_si128(v, mask), pair), quad);
+
+    return _mm_or_si128(_mm_sll_epi64(x, count), _mm_srli_epi64(x, 32));
+}
+
+// SSSE3 extract at depth 2..4 : 16 cover bytes back into 2 * depth payload bytes per iteration
+__attribute__((target("ssse3")))
+static void lsb_extract_bits_ssse3(unsigned char *data, size_t size, const unsigned char *image_buffer, int depth)
+{
+    unsigned char order[16];
+    const __m128i mask = _mm_set1_epi8((1 << depth) - 1);
+    const __m128i pair = _mm_set1_epi16((short)(1 << 8 | 1 << depth));
+    const __m128i quad = _mm_set1_epi32(1 << 16 | 1 << (2 * depth));
+    const __m128i count = _mm_cvtsi32_si128(4 * depth);
+    __m128i gather;
+    size_t i;
+
+    lsb_gather_table(order, depth);
+    gather = _mm_loadu_si128((const __m128i *)order);
+
+    // The store writes 16 payload bytes, the ones past 2 * depth are written again next time
+    for (i = 0; i + 16 <= size; i += 2 * depth)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)image_buffer);
+
+        v = lsb_gather_ssse3(v, mask, pair, quad, count);
+        _mm_storeu_si128((__m128i *)(data + i), _mm_shuffle_epi8(v, gather));
+        image_buffer += 16;
+    }
+
+    lsb_extract_bits(data + i, size - i, image_buffer, depth);
+}
+
+// AVX2 embed at depth 2..4 : 4 * depth payload bytes into 32 cover bytes per iteration
+// Both lanes see the same 16 payload bytes, groups 0 / 1 are spread in the low lane and 2 / 3 in the high one
+__attribute__((target("avx2")))
+static void lsb_embed_bits_avx2(const unsigned char *data, size_t size, unsigned char *image_buffer, int depth)
+{
+    unsigned char shuffle[2][32];
+    unsigned short shift[8];
+    __m256i spread_a, spread_b, mul, keep;
+    __m128i count;
+    size_t i;
+
+    lsb_spread_table(shuffle[0], shift, 0, depth);
+    lsb_spread_table(shuffle[0] + 16, shift, 2 * depth, depth);
+    lsb_spread_table(shuffle[1], shift, depth, depth);
+    lsb_spread_table(shuffle[1] + 16, shift, 3 * depth, depth);
+    spread_a = _mm256_loadu_si256((const __m256i *)shuffle[0]);
+    spread_b = _mm256_loadu_si256((const __m256i *)shuffle[1]);
+    mul = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)shift));
+    keep = _mm256_set1_epi8((char)~((1 << depth) - 1));
+    count = _mm_cvtsi32_si128(16 - depth);
+
+    for (i = 0; i + 16 <= size; i += 4 * depth)
+    {
+        __m256i x = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(data + i)));
+        __m256i a = _mm256_srl_epi16(_mm256_mullo_epi16(_mm256_shuffle_epi8(x, spread_a), mul), count);
+        __m256i b = _mm256_srl_epi16(_mm256_mullo_epi16(_mm256_shuffle_epi8(x, spread_b), mul), count);
+        __m256i img = _mm256_loadu_si256((const __m256i *)image_buffer);
+
+        // packus works per lane, so the low lane holds groups 0 and 1 and the high lane 2 and 3
+        img = _mm256_or_si256(_mm256_and_si256(img, keep), _mm256_packus_epi16(a, b));
+        _mm256_storeu_si256((__m256i *)image_buffer, img);
+        image_buffer += 32;
+    }
+
+    lsb_embed_bits(data + i, size - i, image_buffer, depth);
+}
+
+// AVX2 extract at depth 2..4 : 32 cover bytes back into 4 * depth payload bytes per iteration
+__attribute__((target("avx2")))
+static void lsb_extract_bits_avx2(unsigned char *data, size_t size, const unsigned char *image_buffer, int depth)
+{
+    unsigned char order[16];
+    const __m256i mask = _mm256_set1_epi8((1 << depth) - 1);
+    const __m256i pair = _mm256_set1_epi16((short)(1 << 8 | 1 << depth));
+    const __m256i quad = _mm256_set1_epi32(1 << 16 | 1 << (2 * depth));
+    const __m128i count = _mm_cvtsi32_si128(4 * depth);
+    __m256i gather;
+    size_t i;
+
+    lsb_gather_table(order, depth);
+    gather = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)order));
+
+    // Each lane's 2 * depth bytes are stored 16 wide, the high lane's store overwrites the low lane's spare bytes
+    for (i = 0; i + 32 <= size; i += 4 * depth)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)image_buffer);
+        __m256i x = _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_and_si256(v, mask), pair), quad);
+
+        x = _mm256_or_si256(_mm256_sll_epi64(x, count), _mm256_srli_epi64(x, 32));
+        x = _mm256_shuffle_epi8(x, gather);
+        _mm_storeu_si128((__m128i *)(data + i), _mm256_castsi256_si128(x));
+        _mm_storeu_si128((__m128i *)(data + i + 2 * depth), _mm256_extracti128_si256(x, 1));
+        image_buffer += 32;
+    }
+
+    lsb_extract_bits(data + i, size - i, image_buffer, depth);
+}
+
+#endif
+
+// Kernel forced by lsb_set_kernel(), LSB_KERNEL_AUTO picks one per call
+static LsbKernel lsb_kernel = LSB_KERNEL_AUTO;
+
+// Widest depth 1 kernel the CPU supports
+static LsbKernel lsb_best_kernel(void)
+{
+#ifdef LSB_X86
+    if (__builtin_cpu_supports("avx2"))
+        return LSB_KERNEL_AVX2;
+    if (__builtin_cpu_supports("ssse3"))
+        return LSB_KERNEL_SSSE3;
+    if (__builtin_cpu_supports("sse2"))
+        return LSB_KERNEL_SSE2;
+#endif
+    return LSB_KERNEL_SCALAR;
+}
+
+int lsb_set_kernel(LsbKernel kernel)
+{
+    // Every wider kernel needs the narrower ones' instructions too
+    if (kernel > lsb_best_kernel())
+        return 0;
+
+    lsb_kernel = kernel;
+    return 1;
+}
+
+// Embed payload bytes using the widest kernel the CPU supports
+void lsb_embed(const char *data, size_t size, char *image_buffer, int depth)
+{
+    LsbKernel kernel = lsb_kernel == LSB_KERNEL_AUTO ? lsb_best_kernel() : lsb_kernel;
+
+    if (depth > 1)
+    {
+#ifdef LSB_X86
+        if (kernel == LSB_KERNEL_AVX2)
+            lsb_embed_bits_avx2((const unsigned char *)data, size, (unsigned char *)image_buffer, depth);
+        else if (kernel == LSB_KERNEL_SSSE3)
+            lsb_embed_bits_ssse3((const unsigned char *)data, size, (unsigned char *)image_buffer, depth);
+        else
+#endif
+            lsb_embed_bits((const unsigned char *)data, size, (unsigned char *)image_buffer, depth);
+        return;
+    }
+
+    switch (kernel)
+    {
+#ifdef LSB_X86
+        case LSB_KERNEL_AVX2:
+            lsb_embed_avx2((const unsigned char *)data, size, (unsigned char *)image_buffer);
+            break;
+        case LSB_KERNEL_SSSE3:
+        case LSB_KERNEL_SSE2:
+            lsb_embed_sse2((const unsigned char *)data, size, (unsigned char *)image_buffer);
+            break;
+#endif
+        default:
+            lsb_embed_scalar((const unsigned char *)data, size, (unsigned char *)image_buffer);
+    }
+}
+
+// Extract payload bytes using the widest kernel the CPU supports
+void lsb_extract(char *data, size_t size, const char *image_buffer, int depth)
+{
+    LsbKernel kernel = lsb_kernel == LSB_KERNEL_AUTO ? lsb_best_kernel() : lsb_kernel;
+
+    if (depth > 1)
+    {
+#ifdef LSB_X86
+        if (kernel == LSB_KERNEL_AVX2)
+            lsb_extract_bits_avx2((unsigned char *)data, size, (const unsigned char *)image_buffer, depth);
+        else if (kernel == LSB_KERNEL_SSSE3)
+            lsb_extract_bits_ssse3((unsigned char *)data, size, (const unsigned char *)image_buffer, depth);
+        else
+#endif
+            lsb_extract_bits((unsigned char *)data, size, (const unsigned char *)image_buffer, depth);
+        return;
+    }
+
+    switch (kernel)
+    {
+#ifdef LSB_X86
+        case LSB_KERNEL_AVX2:
+            lsb_extract_avx2((unsigned char *)data, size, (const unsigned char *)image_buffer);
+            break;
+        case LSB_KERNEL_SSSE3:
+        case LSB_KERNEL_SSE2:
+            lsb_extract_sse2((unsigned char *)data, size, (const unsigned char *)image_buffer);
+            break;
+#endif
+        default:
+            lsb_extract_scalar((unsigned char *)data, size, (const unsigned char *)image_buffer);
+    }
+}
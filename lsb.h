@@ -0,0 +1,61 @@
+#ifndef LSB_H
+#define LSB_H
+
+#include <stddef.h>
+
+/*
+ * Block LSB kernels shared by encoding and decoding
+ * Payload bits are packed MSB first into the low depth bits of
+ * consecutive cover bytes. At depth 1 every payload byte is spread
+ * over 8 cover bytes, exactly like encode_byte_to_lsb() /
+ * decode_byte_from_lsb(). SSE2 / AVX2 versions of depth 1 and SSSE3 /
+ * AVX2 versions of depths 2 to 4 are picked at runtime, scalar code
+ * otherwise
+ */
+
+/* Supported LSBs per cover byte */
+#define LSB_MIN_DEPTH 1
+#define LSB_MAX_DEPTH 4
+
+/*
+ * depth payload bytes fill exactly 8 cover bytes, so blocks that are a
+ * multiple of 12 (lcm of 1..4) payload bytes start on a whole cover byte
+ */
+#define LSB_ALIGN 12
+
+/* Cover bytes needed for size payload bytes at depth */
+#define LSB_COVER_SIZE(size, depth) (((size) * 8 + (depth) - 1) / (depth))
+
+/*
+ * Payload bytes that fit in cover bytes at depth, the inverse of
+ * LSB_COVER_SIZE() worked out without multiplying the size by 8, so
+ * untrusted sizes can be checked against it without overflowing
+ */
+#define LSB_PAYLOAD_SIZE(cover, depth) ((cover) / 8 * (depth) + (cover) % 8 * (depth) / 8)
+
+/*
+ * Kernels, widest last. Depth 1 has no SSSE3 kernel and runs SSE2 under it,
+ * depths 2 to 4 have no SSE2 kernel and run scalar under it
+ */
+typedef enum
+{
+    LSB_KERNEL_AUTO,
+    LSB_KERNEL_SCALAR,
+    LSB_KERNEL_SSE2,
+    LSB_KERNEL_SSSE3,
+    LSB_KERNEL_AVX2
+} LsbKernel;
+
+/*
+ * Make lsb_embed() / lsb_extract() use kernel (benchmarks), LSB_KERNEL_AUTO
+ * goes back to the widest the CPU supports. Returns 0 if the CPU lacks kernel
+ */
+int lsb_set_kernel(LsbKernel kernel);
+
+/* Embed size payload bytes into the first LSB_COVER_SIZE(size, depth) bytes of image_buffer */
+void lsb_embed(const char *data, size_t size, char *image_buffer, int depth);
+
+/* Extract size payload bytes from the first LSB_COVER_SIZE(size, depth) bytes of image_buffer */
+void lsb_extract(char *data, size_t size, const char *image_buffer, int depth);
+
+#endif
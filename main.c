@@ -6,9 +6,299 @@ Description :Steganography Project
 */
 
 #include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
 #include "encode.h"
 #include "types.h"
 #include "decode.h"
+#include "batch.h"
+#include "scan.h"
+#include "stats.h"
+#include "aead.h"
+
+/* Usage line of each operation, %s is the program name */
+#define USAGE_ENCODE "📥 To encode : %s -e <input.bmp|-> <secret.txt|.c|.sh|-> [optional output.bmp|-] [--mmap] [-j N] [--depth 1-4] [--compress] [--add FILE]... [--passphrase FILE] [--scatter FILE] [--fec N] [--quiet] [--stats] [--stats-json FILE]\n"
+#define USAGE_DECODE "📤 To decode : %s -d <stego_image.bmp|-> [optional output_file|-] [--mmap] [-j N] [--range OFFSET:LEN] [--list] [--entry NAME] [--verify] [--passphrase FILE] [--scatter FILE] [--quiet] [--stats] [--stats-json FILE]\n"
+#define USAGE_BATCH  "📚 To batch  : %s -b <manifest.txt | cover_dir out_dir> [--mmap] [-j N] [--depth 1-4] [--compress] [--quiet]\n"
+#define USAGE_SCAN   "🔎 To scan   : %s --scan <directory> [-j N] [--quiet]\n"
+
+/* One bit per switch in CmdOptions.given, in the order of option_names[] */
+enum
+{
+    OPT_MMAP       = 1 << 0,
+    OPT_THREADS    = 1 << 1,
+    OPT_DEPTH      = 1 << 2,
+    OPT_COMPRESS   = 1 << 3,
+    OPT_QUIET      = 1 << 4,
+    OPT_STATS      = 1 << 5,
+    OPT_STATS_JSON = 1 << 6,
+    OPT_RANGE      = 1 << 7,
+    OPT_ADD        = 1 << 8,
+    OPT_LIST       = 1 << 9,
+    OPT_ENTRY      = 1 << 10,
+    OPT_VERIFY     = 1 << 11,
+    OPT_PASSPHRASE = 1 << 12,
+    OPT_SCATTER    = 1 << 13,
+    OPT_FEC        = 1 << 14
+};
+
+static const char *option_names[] =
+{
+    "--mmap", "-j", "--depth", "--compress", "--quiet", "--stats", "--stats-json", "--range",
+    "--add", "--list", "--entry", "--verify", "--passphrase", "--scatter", "--fec"
+};
+
+/* Switches each operation takes, anything else given with it is an error */
+#define ENCODE_OPTIONS (OPT_MMAP | OPT_THREADS | OPT_DEPTH | OPT_COMPRESS | OPT_QUIET | OPT_STATS | OPT_STATS_JSON | \
+                        OPT_ADD | OPT_PASSPHRASE | OPT_SCATTER | OPT_FEC)
+#define DECODE_OPTIONS (OPT_MMAP | OPT_THREADS | OPT_QUIET | OPT_STATS | OPT_STATS_JSON | OPT_RANGE | OPT_LIST | \
+                        OPT_ENTRY | OPT_VERIFY | OPT_PASSPHRASE | OPT_SCATTER)
+#define BATCH_OPTIONS  (OPT_MMAP | OPT_THREADS | OPT_DEPTH | OPT_COMPRESS | OPT_QUIET)
+#define SCAN_OPTIONS   (OPT_THREADS | OPT_QUIET)
+
+/* Options given as switches anywhere after -e / -d */
+typedef struct
+{
+    /* OPT_* bits of the switches that were given */
+    unsigned given;
+
+    int use_mmap;
+    int threads;
+    int depth;
+    int compress;
+    int quiet;
+    int stats;
+    const char *stats_json;
+    long range_offset;
+    long range_size;
+    int list;
+    const char *entry;
+    int verify;
+    const char *passphrase_file;
+    const char *scatter_file;
+    int fec;
+
+    /* --add FILE, slot 0 is left for the secret file */
+    char **files;
+    int nfiles;
+} CmdOptions;
+
+// Parse a whole decimal argument in [min, max], atoi() would take "4x" as 4
+static int parse_count(const char *arg, int min, int max, int *value)
+{
+    char *end;
+    long n = strtol(arg, &end, 10);
+
+    if (end == arg || *end != '\0' || n < min || n > max)
+        return 0;
+    *value = (int)n;
+    return 1;
+}
+
+// Name the first switch that the operation doesn't take, it would be ignored otherwise
+static Status check_mode_options(const CmdOptions *opts, unsigned allowed, const char *operation)
+{
+    unsigned i;
+
+    for (i = 0; i < sizeof(option_names) / sizeof(option_names[0]); i++)
+    {
+        if ((opts->given & ~allowed) & (1u << i))
+        {
+            printf("ERROR ❌ : %s can't be used for %s\n", option_names[i], operation);
+            return e_failure;
+        }
+    }
+    return e_success;
+}
+
+// Move the --switches (and -j N, --depth N) out of argv so only positional arguments are left
+// Returns the new argument count, or -1 for an unknown switch
+static int extract_options(int argc, char *argv[], CmdOptions *opts)
+{
+    int i, n = 2;
+
+    memset(opts, 0, sizeof(*opts));
+    opts->threads = 1;
+    opts->depth = 1;
+    opts->range_size = -1;
+    opts->files = calloc(argc + 1, sizeof(char *));
+    opts->nfiles = 1;
+    if (opts->files == NULL)
+        return -1;
+
+    for (i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--mmap") == 0)
+        {
+            opts->use_mmap = 1;
+            opts->given |= OPT_MMAP;
+        }
+        else if (strcmp(argv[i], "--compress") == 0)
+        {
+            // zlib the secret before embedding it
+            opts->compress = 1;
+            opts->given |= OPT_COMPRESS;
+        }
+        else if (strcmp(argv[i], "--quiet") == 0 || strcmp(argv[i], "-q") == 0)
+        {
+            // No per-stage progress messages, errors are still printed
+            opts->quiet = 1;
+            opts->given |= OPT_QUIET;
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+        {
+            // Per-stage time, bytes and syscalls after the run
+            opts->stats = 1;
+            opts->given |= OPT_STATS;
+        }
+        else if (strcmp(argv[i], "--stats-json") == 0)
+        {
+            // Same as JSON, to a file or "-" for the message stream
+            if (i + 1 >= argc)
+            {
+                printf("ERROR ❌ : --stats-json needs a file name (or -)\n");
+                return -1;
+            }
+            opts->stats_json = argv[++i];
+            opts->given |= OPT_STATS_JSON;
+        }
+        else if (strcmp(argv[i], "--range") == 0)
+        {
+            // Decode only LEN secret bytes starting at OFFSET
+            char *end;
+
+            if (i + 1 < argc)
+            {
+                opts->range_offset = strtol(argv[i + 1], &end, 0);
+                if (*end == ':')
+                    opts->range_size = strtol(end + 1, &end, 0);
+            }
+            if (i + 1 >= argc || *end != '\0' || opts->range_offset < 0 || opts->range_size < 0)
+            {
+                printf("ERROR ❌ : --range needs OFFSET:LEN\n");
+                return -1;
+            }
+            opts->given |= OPT_RANGE;
+            i++;
+        }
+        else if (strcmp(argv[i], "--add") == 0)
+        {
+            // Pack one more file with the secret file into a container
+            if (i + 1 >= argc)
+            {
+                printf("ERROR ❌ : --add needs a file name\n");
+                return -1;
+            }
+            opts->files[opts->nfiles++] = argv[++i];
+            opts->given |= OPT_ADD;
+        }
+        else if (strcmp(argv[i], "--list") == 0)
+        {
+            // Print the files of a container image
+            opts->list = 1;
+            opts->given |= OPT_LIST;
+        }
+        else if (strcmp(argv[i], "--entry") == 0)
+        {
+            // Extract one file of a container image
+            if (i + 1 >= argc)
+            {
+                printf("ERROR ❌ : --entry needs a file name\n");
+                return -1;
+            }
+            opts->entry = argv[++i];
+            opts->given |= OPT_ENTRY;
+        }
+        else if (strcmp(argv[i], "--verify") == 0)
+        {
+            // Check the checksums of a stego image without writing the secret
+            opts->verify = 1;
+            opts->given |= OPT_VERIFY;
+        }
+        else if (strcmp(argv[i], "--passphrase") == 0)
+        {
+            // Encrypt / decrypt the secret with the passphrase on the first line of FILE
+            if (i + 1 >= argc)
+            {
+                printf("ERROR ❌ : --passphrase needs a file name\n");
+                return -1;
+            }
+            opts->passphrase_file = argv[++i];
+            opts->given |= OPT_PASSPHRASE;
+        }
+        else if (strcmp(argv[i], "--scatter") == 0)
+        {
+            // Spread the secret over the pixels in an order keyed by the first line of FILE
+            if (i + 1 >= argc)
+            {
+                printf("ERROR ❌ : --scatter needs a file name\n");
+                return -1;
+            }
+            opts->scatter_file = argv[++i];
+            opts->given |= OPT_SCATTER;
+        }
+        else if (strcmp(argv[i], "--fec") == 0)
+        {
+            // Reed-Solomon parity bytes per 255 byte codeword when encoding
+            if (i + 1 >= argc || !parse_count(argv[i + 1], FEC_MIN_PARITY, FEC_MAX_PARITY, &opts->fec))
+            {
+                printf("ERROR ❌ : --fec needs %d to %d parity bytes per codeword\n", FEC_MIN_PARITY, FEC_MAX_PARITY);
+                return -1;
+            }
+            opts->given |= OPT_FEC;
+            i++;
+        }
+        else if (strcmp(argv[i], "-j") == 0)
+        {
+            // Number of threads for the secret data stage
+            if (i + 1 >= argc || !parse_count(argv[i + 1], 1, INT_MAX, &opts->threads))
+            {
+                printf("ERROR ❌ : -j needs a thread count of at least 1\n");
+                return -1;
+            }
+            opts->given |= OPT_THREADS;
+            i++;
+        }
+        else if (strcmp(argv[i], "--depth") == 0)
+        {
+            // LSBs per cover byte used when encoding
+            if (i + 1 >= argc || !parse_count(argv[i + 1], LSB_MIN_DEPTH, LSB_MAX_DEPTH, &opts->depth))
+            {
+                printf("ERROR ❌ : --depth needs %d to %d bits per byte\n", LSB_MIN_DEPTH, LSB_MAX_DEPTH);
+                return -1;
+            }
+            opts->given |= OPT_DEPTH;
+            i++;
+        }
+        else if (strncmp(argv[i], "--", 2) == 0)
+        {
+            printf("ERROR ❌ : Unknown option %s\n", argv[i]);
+            return -1;
+        }
+        else
+        {
+            argv[n++] = argv[i];
+        }
+    }
+
+    argv[n] = NULL;
+    return n;
+}
+
+// Print / write the stats of the run that just finished, if they were asked for
+static Status report_stats(StegoStats *stats, const CmdOptions *opts)
+{
+    if (!opts->stats && !opts->stats_json)
+        return e_success;
+
+    stats_end(stats);
+    if (opts->stats)
+        stats_print(stats, stdout);
+    if (opts->stats_json)
+        return stats_write_json(stats, opts->stats_json);
+    return e_success;
+}
 
 int main(int argc, char *argv[])
 {
@@ -16,16 +306,41 @@ int main(int argc, char *argv[])
     if(argc < 2)
     {
         // Display usage instructions
-        printf("➡️  Use -e for encoding or -d for decoding\n");
+        printf("➡️  Use -e for encoding, -d for decoding, -b for batch encoding or --scan to find stego images\n");
         printf("📌 Usage:\n");
-        printf("📥 To encode : %s -e <input.bmp> <secret.txt|.c|.sh> [optional output.bmp]\n", argv[0]);
-        printf("📤 To decode : %s -d <stego_image.bmp> [optional output_file]\n", argv[0]);
+        printf(USAGE_ENCODE, argv[0]);
+        printf(USAGE_DECODE, argv[0]);
+        printf(USAGE_BATCH, argv[0]);
+        printf(USAGE_SCAN, argv[0]);
         return e_failure;
     }
 
     // Declare encode and decode info structures
     EncodeInfo encodeInfo; //structure
     DecodeInfo decInfo;
+    CmdOptions opts;
+    StegoStats stats;
+    char passphrase[AEAD_MAX_PASSPHRASE + 2];
+    char scatter_key[AEAD_MAX_PASSPHRASE + 2];
+
+    // Pull out --options, the argument counts below are for positional arguments
+    argc = extract_options(argc, argv, &opts);
+    if(argc < 0)
+    {
+        return 1;
+    }
+    stego_quiet = opts.quiet;
+
+    if (opts.passphrase_file != NULL && aead_read_passphrase(opts.passphrase_file, passphrase) == e_failure)
+    {
+        return 1;
+    }
+
+    // The scatter key is read like a passphrase, first line of the file
+    if (opts.scatter_file != NULL && aead_read_passphrase(opts.scatter_file, scatter_key) == e_failure)
+    {
+        return 1;
+    }
 
     // Determine operation type using CLA
     if(check_operation_type(argv) == e_encode)
@@ -33,11 +348,74 @@ int main(int argc, char *argv[])
         // For encoding, expect 4 or 5 arguments
         if(argc >= 4 && argc <= 5)
         {
+            if (check_mode_options(&opts, ENCODE_OPTIONS, "encoding") == e_failure)
+            {
+                printf("📌 Usage:\n");
+                printf(USAGE_ENCODE, argv[0]);
+                return 1;
+            }
+
             // Validate encode arguments
             if(read_and_validate_encode_args(argv, &encodeInfo) == e_failure)
             {
                 return 1;
             }
+            encodeInfo.use_mmap = opts.use_mmap;
+            encodeInfo.threads = opts.threads;
+            encodeInfo.depth = opts.depth;
+            if (opts.compress)
+                encodeInfo.flags |= STEGO_FLAG_FRAMED | STEGO_FLAG_DEFLATE;
+
+            // --add : the secret file and the added ones go into one container payload
+            if (opts.nfiles > 1)
+            {
+                if (encodeInfo.flags & STEGO_FLAG_FRAMED)
+                {
+                    printf("ERROR ❌ : --add can't be used with --compress or a secret from stdin\n");
+                    return 1;
+                }
+                opts.files[0] = encodeInfo.secret_fname;
+                encodeInfo.container_files = opts.files;
+                encodeInfo.container_count = opts.nfiles;
+                encodeInfo.flags |= STEGO_FLAG_CONTAINER;
+                strcpy(encodeInfo.extn_secret_file, "");
+            }
+
+            // --passphrase : seal the secret while it is embedded
+            if (opts.passphrase_file != NULL)
+            {
+                if (encodeInfo.flags & STEGO_FLAG_CONTAINER)
+                {
+                    printf("ERROR ❌ : --passphrase can't be used with --add\n");
+                    return 1;
+                }
+                encodeInfo.passphrase = passphrase;
+                encodeInfo.flags |= STEGO_FLAG_ENCRYPTED;
+            }
+
+            // --scatter : cells are visited in key order, only the mapped stego image allows that
+            if (opts.scatter_file != NULL)
+            {
+                encodeInfo.scatter_key = scatter_key;
+                encodeInfo.flags |= STEGO_FLAG_SCATTER;
+                encodeInfo.use_mmap = 1;
+            }
+
+            // --fec : parity is added over whole blocks after the data, only the mapped stego image allows that
+            if (opts.fec > 0)
+            {
+                if (opts.scatter_file != NULL)
+                {
+                    printf("ERROR ❌ : --fec can't be used with --scatter\n");
+                    return 1;
+                }
+                encodeInfo.fec_parity = opts.fec;
+                encodeInfo.flags |= STEGO_FLAG_FEC;
+                encodeInfo.use_mmap = 1;
+            }
+
+            if (opts.stats || opts.stats_json)
+                stats_begin(&stats, "encode");
 
             // start the encoding
             if(do_encoding(&encodeInfo) == e_failure)
@@ -50,29 +428,58 @@ int main(int argc, char *argv[])
 
             // Close all opened files after encoding
             close_enc_files(&encodeInfo);
+
+            if (report_stats(&stats, &opts) == e_failure)
+                return 1;
         }
         else
         {
             // Insufficient or too many arguments for encoding
             printf("ERROR ❌ : Invalid number of arguments for encoding\n");
             printf("📌 Usage:\n");
-            printf("📥 To encode : %s -e <input.bmp> <secret.txt|.c|.sh> [optional output.bmp]\n", argv[0]);
+            printf(USAGE_ENCODE, argv[0]);
             return 1;
         }
 
         // Successful encoding
-        printf("INFO ✅ : ## Encoding Done Successfully ## 🎉\n\n");
+        INFO_PRINTF("INFO ✅ : ## Encoding Done Successfully ## 🎉\n\n");
     }
     else if(check_operation_type(argv) == e_decode)
     {
         if (argc >= 3 && argc <= 4)
         {
             // For decoding, expect 3 or 4 arguments
+            if (check_mode_options(&opts, DECODE_OPTIONS, "decoding") == e_failure)
+            {
+                printf("📌 Usage:\n");
+                printf(USAGE_DECODE, argv[0]);
+                return 1;
+            }
+
             if(read_and_validate_decode_args(argv, &decInfo) == e_failure)
                 return 1;
+            decInfo.use_mmap = opts.use_mmap;
+            decInfo.threads = opts.threads;
+            decInfo.range_offset = opts.range_offset;
+            decInfo.range_size = opts.range_size;
+            decInfo.list = opts.list;
+            decInfo.entry = opts.entry;
+            decInfo.verify = opts.verify;
+            decInfo.passphrase = opts.passphrase_file != NULL ? passphrase : NULL;
+            decInfo.scatter_key = opts.scatter_file != NULL ? scatter_key : NULL;
+
+            // The checksum covers the whole secret, a range can't be checked against it
+            if (opts.verify && (opts.range_size >= 0 || opts.list))
+            {
+                printf("ERROR ❌ : --verify can't be used with --range or --list\n");
+                return 1;
+            }
 
             // Begin decoding process
-            printf("INFO 🚀 : ## Decoding Procedure Started ## 🔍\n\n");
+            INFO_PRINTF("INFO 🚀 : ## Decoding Procedure Started ## 🔍\n\n");
+
+            if (opts.stats || opts.stats_json)
+                stats_begin(&stats, "decode");
 
             if(do_decoding(&decInfo) == e_failure)
             {
@@ -82,27 +489,86 @@ int main(int argc, char *argv[])
             }
 
             close_dec_files(&decInfo); // Close files if failure
+
+            if (report_stats(&stats, &opts) == e_failure)
+                return 1;
         }
         else
         {
             // Incorrect argument count for decoding
             printf("ERROR ❌ : Invalid number of arguments for decoding\n");
             printf("📌 Usage:\n");
-            printf("📤 To decode : %s -d <stego_image.bmp> [optional output_file]\n", argv[0]);
+            printf(USAGE_DECODE, argv[0]);
             return 1;
         }
 
         // Successful decoding
-        printf("INFO ✅ : ## Decoding Done Successfully ## 🎉\n\n");
+        if (opts.verify)
+            INFO_PRINTF("INFO ✅ : ## Verification Done Successfully ## 🎉\n\n");
+        else
+            INFO_PRINTF("INFO ✅ : ## Decoding Done Successfully ## 🎉\n\n");
+    }
+    else if(check_operation_type(argv) == e_batch)
+    {
+        // For batch encoding, expect the manifest or a cover and an output directory
+        if(argc != 3 && argc != 4)
+        {
+            printf("ERROR ❌ : Invalid number of arguments for batch encoding\n");
+            printf("📌 Usage:\n");
+            printf(USAGE_BATCH, argv[0]);
+            return 1;
+        }
+
+        if (check_mode_options(&opts, BATCH_OPTIONS, "batch encoding") == e_failure)
+        {
+            printf("📌 Usage:\n");
+            printf(USAGE_BATCH, argv[0]);
+            return 1;
+        }
+
+        // -j N is the number of jobs running at once, the other options apply to every job
+        encodeInfo.use_mmap = opts.use_mmap;
+        encodeInfo.depth = opts.depth;
+        encodeInfo.flags = opts.compress ? STEGO_FLAG_FRAMED | STEGO_FLAG_DEFLATE : 0;
+        if(do_batch(argv[2], argc == 4 ? argv[3] : NULL, opts.threads, &encodeInfo) == e_failure)
+        {
+            printf("ERROR ❌ : Some batch jobs failed\n");
+            return 1;
+        }
+
+        INFO_PRINTF("INFO ✅ : ## Batch Done Successfully ## 🎉\n\n");
+    }
+    else if(check_operation_type(argv) == e_scan)
+    {
+        // For scanning, expect just the directory, only stego images are printed
+        if(argc != 3)
+        {
+            printf("ERROR ❌ : Invalid number of arguments for scanning\n");
+            printf("📌 Usage:\n");
+            printf(USAGE_SCAN, argv[0]);
+            return 1;
+        }
+
+        if (check_mode_options(&opts, SCAN_OPTIONS, "scanning") == e_failure)
+        {
+            printf("📌 Usage:\n");
+            printf(USAGE_SCAN, argv[0]);
+            return 1;
+        }
+
+        if(do_scan(argv[2], opts.threads) == e_failure)
+            return 1;
     }
     else
     {
-        // Invalid operation type (not -e or -d)
+        // Invalid operation type (not -e, -d, -b or --scan)
         printf("ERROR ❌ : Unsupported operation\n");
-        printf("➡️  Use -e for encoding or -d for decoding\n");
+        printf("➡️  Use -e for encoding, -d for decoding, -b for batch encoding or --scan to find stego images\n");
         printf("📌 Usage:\n");
-        printf("📥 To encode : %s -e <input.bmp> <secret.txt|.c|.sh> [optional output.bmp]\n", argv[0]);
-        printf("📤 To decode : %s -d <stego_image.bmp> [optional output_file]\n", argv[0]);
+        printf(USAGE_ENCODE, argv[0]);
+        printf(USAGE_DECODE, argv[0]);
+        printf(USAGE_BATCH, argv[0]);
+        printf(USAGE_SCAN, argv[0]);
     }
 
     return 0;
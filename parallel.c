@@ -0,0 +1,309 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project
+*/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include "parallel.h"
+#include "crc32c.h"
+
+/* One stripe handed to a thread */
+typedef struct
+{
+    StripeFn fn;
+    void *arg;
+    long begin;
+    long end;
+    Status status;
+} Stripe;
+
+static void *stripe_thread(void *data)
+{
+    Stripe *stripe = data;
+
+    stripe->status = stripe->fn(stripe->arg, stripe->begin, stripe->end);
+    return NULL;
+}
+
+// Split the payload into stripes, the calling thread runs the first one itself
+Status run_stripes(int nthreads, long total, long min_stripe, long align, StripeFn fn, void *arg)
+{
+    Stripe *stripes;
+    pthread_t *tids;
+    Status status = e_success;
+    long per;
+    int i, started;
+
+    if (min_stripe < 1)
+        min_stripe = 1;
+    if (align < 1)
+        align = 1;
+
+    // No point in starting threads for stripes smaller than min_stripe
+    if (nthreads > total / min_stripe)
+        nthreads = total / min_stripe;
+
+    if (nthreads <= 1)
+        return fn(arg, 0, total);
+
+    stripes = calloc(nthreads, sizeof(*stripes));
+    tids = calloc(nthreads, sizeof(*tids));
+    if (stripes == NULL || tids == NULL)
+    {
+        free(stripes);
+        free(tids);
+        return fn(arg, 0, total);
+    }
+
+    per = (total + nthreads - 1) / nthreads;
+    per = (per + align - 1) / align * align;
+    for (i = 0; i < nthreads; i++)
+    {
+        stripes[i].fn = fn;
+        stripes[i].arg = arg;
+        stripes[i].begin = i * per < total ? i * per : total;
+        stripes[i].end = (i + 1) * per < total ? (i + 1) * per : total;
+    }
+
+    for (started = 1; started < nthreads; started++)
+    {
+        if (pthread_create(&tids[started], NULL, stripe_thread, &stripes[started]) != 0)
+            break;
+    }
+
+    stripe_thread(&stripes[0]);
+
+    // Stripes whose thread couldn't be started run here
+    for (i = started; i < nthreads; i++)
+        stripe_thread(&stripes[i]);
+
+    for (i = 1; i < started; i++)
+        pthread_join(tids[i], NULL);
+
+    for (i = 0; i < nthreads; i++)
+    {
+        if (stripes[i].status == e_failure)
+            status = e_failure;
+    }
+
+    free(stripes);
+    free(tids);
+    return status;
+}
+
+// run_stripes() makes at most nthreads stripes, or one when it falls back to the calling thread
+Status stripe_crc_init(StripeCrc *sc, int nthreads)
+{
+    sc->count = 0;
+    sc->pieces = malloc((nthreads > 1 ? nthreads : 1) * sizeof(CrcPiece));
+    if (sc->pieces == NULL)
+        return e_failure;
+    pthread_mutex_init(&sc->lock, NULL);
+    return e_success;
+}
+
+void stripe_crc_add(StripeCrc *sc, long begin, long end, uint crc)
+{
+    pthread_mutex_lock(&sc->lock);
+    sc->pieces[sc->count].begin = begin;
+    sc->pieces[sc->count].end = end;
+    sc->pieces[sc->count].crc = crc;
+    sc->count++;
+    pthread_mutex_unlock(&sc->lock);
+}
+
+// Stripes finish in any order, sort the few pieces by offset and combine them
+uint stripe_crc_finish(StripeCrc *sc)
+{
+    CrcPiece piece;
+    uint crc = 0;
+    int i, j;
+
+    for (i = 1; i < sc->count; i++)
+    {
+        piece = sc->pieces[i];
+        for (j = i; j > 0 && sc->pieces[j - 1].begin > piece.begin; j--)
+            sc->pieces[j] = sc->pieces[j - 1];
+        sc->pieces[j] = piece;
+    }
+
+    for (i = 0; i < sc->count; i++)
+        crc = crc32c_combine(crc, sc->pieces[i].crc, sc->pieces[i].end - sc->pieces[i].begin);
+
+    pthread_mutex_destroy(&sc->lock);
+    free(sc->pieces);
+    sc->pieces = NULL;
+    return crc;
+}
+
+/* Buffers of a pipeline and the blocks each stage is done with */
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    PipeFn read;
+    PipeFn write;
+    void *arg;
+    char *buffers;
+    size_t size;
+    int nbuffers;
+    long count;
+    long read_done;
+    long work_done;
+    long write_done;
+    int failed;
+} Pipeline;
+
+// Wait until block index may enter a stage, *before being the blocks done by the stage ahead of it
+// lag lets the reader run that many blocks ahead of the writer. Returns 0 once the pipeline failed
+static int pipe_wait(Pipeline *pipe, const long *before, long index, long lag)
+{
+    int ok;
+
+    pthread_mutex_lock(&pipe->lock);
+    while (!pipe->failed && *before + lag <= index)
+        pthread_cond_wait(&pipe->cond, &pipe->lock);
+    ok = !pipe->failed;
+    pthread_mutex_unlock(&pipe->lock);
+
+    return ok;
+}
+
+// Hand the block a stage finished on to the next one
+static void pipe_done(Pipeline *pipe, long *done, Status status)
+{
+    pthread_mutex_lock(&pipe->lock);
+    if (status == e_failure)
+        pipe->failed = 1;
+    else
+        (*done)++;
+    pthread_cond_broadcast(&pipe->cond);
+    pthread_mutex_unlock(&pipe->lock);
+}
+
+static void *pipe_reader(void *data)
+{
+    Pipeline *pipe = data;
+    long i;
+
+    // A buffer is free again once its last block is written
+    for (i = 0; i < pipe->count && pipe_wait(pipe, &pipe->write_done, i, pipe->nbuffers); i++)
+        pipe_done(pipe, &pipe->read_done, pipe->read(pipe->arg, i, pipe->buffers + i % pipe->nbuffers * pipe->size));
+    return NULL;
+}
+
+static void *pipe_writer(void *data)
+{
+    Pipeline *pipe = data;
+    long i;
+
+    for (i = 0; i < pipe->count && pipe_wait(pipe, &pipe->work_done, i, 0); i++)
+        pipe_done(pipe, &pipe->write_done, pipe->write(pipe->arg, i, pipe->buffers + i % pipe->nbuffers * pipe->size));
+    return NULL;
+}
+
+// The calling thread does the work stage, and the read / write stages whose thread couldn't be started
+Status run_pipeline(char *buffers, int nbuffers, size_t size, long count, PipeFn read, PipeFn work, PipeFn write, void *arg)
+{
+    Pipeline pipe;
+    pthread_t reader, writer;
+    int reading, writing;
+    char *buffer;
+    long n;
+
+    // One buffer can't overlap anything, the stages take turns on the calling thread
+    if (nbuffers < 2)
+    {
+        for (n = 0; n < count; n++)
+            if (read(arg, n, buffers) == e_failure || work(arg, n, buffers) == e_failure || write(arg, n, buffers) == e_failure)
+                return e_failure;
+        return e_success;
+    }
+
+    if (count <= 0)
+        return e_success;
+
+    pthread_mutex_init(&pipe.lock, NULL);
+    pthread_cond_init(&pipe.cond, NULL);
+    pipe.read = read;
+    pipe.write = write;
+    pipe.arg = arg;
+    pipe.buffers = buffers;
+    pipe.size = size;
+    pipe.nbuffers = nbuffers;
+    pipe.count = count;
+    pipe.read_done = pipe.work_done = pipe.write_done = 0;
+    pipe.failed = 0;
+
+    reading = pthread_create(&reader, NULL, pipe_reader, &pipe) == 0;
+    writing = pthread_create(&writer, NULL, pipe_writer, &pipe) == 0;
+
+    for (n = 0; n < count; n++)
+    {
+        buffer = buffers + n % nbuffers * size;
+        if (!reading && pipe_wait(&pipe, &pipe.write_done, n, nbuffers))
+            pipe_done(&pipe, &pipe.read_done, read(arg, n, buffer));
+        if (!pipe_wait(&pipe, &pipe.read_done, n, 0))
+            break;
+        pipe_done(&pipe, &pipe.work_done, work(arg, n, buffer));
+        if (!writing && pipe_wait(&pipe, &pipe.work_done, n, 0))
+            pipe_done(&pipe, &pipe.write_done, write(arg, n, buffer));
+    }
+
+    if (reading)
+        pthread_join(reader, NULL);
+    if (writing)
+        pthread_join(writer, NULL);
+
+    pthread_cond_destroy(&pipe.cond);
+    pthread_mutex_destroy(&pipe.lock);
+
+    return pipe.failed ? e_failure : e_success;
+}
+
+// Read exactly len bytes at offset
+Status pread_full(int fd, void *buf, size_t len, off_t offset)
+{
+    char *p = buf;
+    ssize_t n;
+
+    while (len > 0)
+    {
+        n = pread(fd, p, len, offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return e_failure;
+        p += n;
+        offset += n;
+        len -= n;
+    }
+
+    return e_success;
+}
+
+// Write exactly len bytes at offset
+Status pwrite_full(int fd, const void *buf, size_t len, off_t offset)
+{
+    const char *p = buf;
+    ssize_t n;
+
+    while (len > 0)
+    {
+        n = pwrite(fd, p, len, offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return e_failure;
+        p += n;
+        offset += n;
+        len -= n;
+    }
+
+    return e_success;
+}
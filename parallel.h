@@ -0,0 +1,67 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <pthread.h>
+#include "types.h"
+
+/*
+ * Striped parallel embedding / extraction
+ * Payload byte i always maps to the same cover bytes, so the payload
+ * can be cut into independent stripes that are processed by threads
+ */
+
+/* Stripe worker : processes payload bytes [begin, end) */
+typedef Status (*StripeFn)(void *arg, long begin, long end);
+
+/*
+ * Cut [0, total) into up to nthreads stripes of at least min_stripe bytes and run them in parallel
+ * Every stripe except the last one is a multiple of align bytes long
+ */
+Status run_stripes(int nthreads, long total, long min_stripe, long align, StripeFn fn, void *arg);
+
+/*
+ * CRC-32C of a striped payload : every stripe adds the checksum of its
+ * [begin, end) and stripe_crc_finish() chains the pieces in payload order
+ */
+typedef struct
+{
+    long begin;
+    long end;
+    uint crc;
+} CrcPiece;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    CrcPiece *pieces;
+    int count;
+} StripeCrc;
+
+/* Room for the pieces of up to nthreads stripes */
+Status stripe_crc_init(StripeCrc *sc, int nthreads);
+
+/* Record the checksum of one stripe, thread safe */
+void stripe_crc_add(StripeCrc *sc, long begin, long end, uint crc);
+
+/* Checksum of the whole payload, releases sc */
+uint stripe_crc_finish(StripeCrc *sc);
+
+/*
+ * Three stage pipeline over blocks [0, count) : read, work, write, each stage taking the
+ * blocks in order. read and write run on threads of their own, work on the calling
+ * thread, so with nbuffers buffers of size bytes the next blocks are read and the
+ * previous ones written while one is worked on. A stage failing stops the others
+ * buffers holds the nbuffers buffers back to back and belongs to the caller. With a
+ * single buffer no thread is started and the stages run in turn
+ */
+typedef Status (*PipeFn)(void *arg, long index, char *buffer);
+
+Status run_pipeline(char *buffers, int nbuffers, size_t size, long count, PipeFn read, PipeFn work, PipeFn write, void *arg);
+
+/* pread / pwrite that retry until len bytes are done */
+Status pread_full(int fd, void *buf, size_t len, off_t offset);
+Status pwrite_full(int fd, const void *buf, size_t len, off_t offset);
+
+#endif
@@ -0,0 +1,204 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <unistd.h>
+#include "scan.h"
+#include "stego.h"
+#include "bmp.h"
+#include "common.h"
+
+/* Open directories nftw() may hold at once */
+#define SCAN_MAX_FDS 64
+
+/* Paths found by the tree walk, shared by the workers */
+typedef struct
+{
+    char **paths;
+    int count;
+    int size;
+    int next;
+    int found;
+    int failed;
+    pthread_mutex_t lock;
+} ScanQueue;
+
+/* nftw() takes no user pointer, the walk fills this list */
+static ScanQueue *scan_queue;
+
+// nftw() callback : collect regular files with a .bmp extension
+static int scan_collect(const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+    const char *ch = strrchr(path, '.');
+    char **grown;
+
+    (void)st;
+    (void)ftw;
+
+    if (type == FTW_DNR)
+    {
+        printf("ERROR ❌ : Can't read directory %s\n", path);
+        scan_queue->failed++;
+        return 0;
+    }
+
+    if (type != FTW_F || ch == NULL || strcasecmp(ch, ".bmp") != 0)
+        return 0;
+
+    if (scan_queue->count == scan_queue->size)
+    {
+        scan_queue->size = scan_queue->size ? scan_queue->size * 2 : 1024;
+        grown = realloc(scan_queue->paths, scan_queue->size * sizeof(*grown));
+        if (grown == NULL)
+            return -1;
+        scan_queue->paths = grown;
+    }
+
+    scan_queue->paths[scan_queue->count] = strdup(path);
+    if (scan_queue->paths[scan_queue->count] == NULL)
+        return -1;
+    scan_queue->count++;
+
+    return 0;
+}
+
+// Check one file, reads the BMP header and stego headers with a single pread
+// (a second one only when the pixels start past STEGO_SCAN_SIZE)
+static void scan_file(const char *path, ScanQueue *queue)
+{
+    char buffer[BMP_MAX_HEADER_SIZE + STEGO_HEADER_SPAN];
+    StegoCtx ctx;
+    BmpInfo bmp;
+    ssize_t n, more;
+    size_t need;
+    int fd;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        pthread_mutex_lock(&queue->lock);
+        queue->failed++;
+        pthread_mutex_unlock(&queue->lock);
+        return;
+    }
+
+    n = pread(fd, buffer, STEGO_SCAN_SIZE, 0);
+
+    // Cheap rejections first : not a supported BMP, or no magic string
+    if (n < BMP_HEADER_SIZE || bmp_parse_header(buffer, n, &bmp) == e_failure)
+    {
+        close(fd);
+        return;
+    }
+
+    need = bmp.pixel_offset + STEGO_HEADER_SPAN;
+    if (need > (size_t)n && n == STEGO_SCAN_SIZE)
+    {
+        more = pread(fd, buffer + n, need - n, n);
+        if (more > 0)
+            n += more;
+    }
+    close(fd);
+
+    stego_ctx_init(&ctx);
+    if (stego_decode_header(&ctx, buffer, n) == e_success)
+    {
+        pthread_mutex_lock(&queue->lock);
+        queue->found++;
+        if (ctx.flags & STEGO_FLAG_FEC)
+            printf("STEGO 🔎 %s : FEC protected, depth %d\n", path, ctx.depth);
+        else if (ctx.flags & STEGO_FLAG_FRAMED)
+            printf("STEGO 🔎 %s : extension '%s', framed%s%s%s, depth %d\n", path, ctx.extn,
+                   ctx.flags & STEGO_FLAG_DEFLATE ? " compressed" : "",
+                   ctx.flags & STEGO_FLAG_ENCRYPTED ? " encrypted" : "",
+                   ctx.flags & STEGO_FLAG_SCATTER ? " scattered" : "", ctx.depth);
+        else
+            printf("STEGO 🔎 %s : %s '%s', %zu bytes%s%s, depth %d\n", path,
+                   ctx.flags & STEGO_FLAG_CONTAINER ? "container" : "extension", ctx.extn, ctx.payload_size,
+                   ctx.flags & STEGO_FLAG_ENCRYPTED ? " encrypted" : "",
+                   ctx.flags & STEGO_FLAG_SCATTER ? " scattered" : "", ctx.depth);
+        pthread_mutex_unlock(&queue->lock);
+    }
+    stego_ctx_free(&ctx);
+}
+
+// Worker : keeps taking the next path until the list is done
+static void *scan_worker(void *data)
+{
+    ScanQueue *queue = data;
+    int index;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&queue->lock);
+        index = queue->next < queue->count ? queue->next++ : -1;
+        pthread_mutex_unlock(&queue->lock);
+
+        if (index < 0)
+            break;
+
+        scan_file(queue->paths[index], queue);
+    }
+
+    return NULL;
+}
+
+// Scan a directory tree
+Status do_scan(const char *dir, int threads)
+{
+    ScanQueue queue;
+    pthread_t *tids;
+    int i, started;
+
+    memset(&queue, 0, sizeof(queue));
+    pthread_mutex_init(&queue.lock, NULL);
+
+    // Walk first, without following symlinks, then hand the paths to the workers
+    scan_queue = &queue;
+    if (nftw(dir, scan_collect, SCAN_MAX_FDS, FTW_PHYS) != 0)
+    {
+        perror("nftw ");
+        printf("ERROR ❌ : Can't scan %s\n", dir);
+        queue.failed++;
+    }
+    scan_queue = NULL;
+
+    if (threads > queue.count)
+        threads = queue.count;
+    if (threads < 1)
+        threads = 1;
+
+    tids = calloc(threads, sizeof(*tids));
+    started = 0;
+    while (tids != NULL && started < threads - 1 && pthread_create(&tids[started], NULL, scan_worker, &queue) == 0)
+        started++;
+
+    scan_worker(&queue);
+
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+
+    fflush(stdout);
+    if (!stego_quiet)
+        fprintf(stderr, "INFO 📊 : Scanned %d .bmp files, %d with a payload, %d unreadable\n",
+                queue.count, queue.found, queue.failed);
+
+    for (i = 0; i < queue.count; i++)
+        free(queue.paths[i]);
+    free(queue.paths);
+    free(tids);
+    pthread_mutex_destroy(&queue.lock);
+
+    return queue.failed ? e_failure : e_success;
+}
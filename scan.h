@@ -0,0 +1,18 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include "types.h"
+
+/*
+ * Scan mode : triage a directory tree for stego images
+ * Only the first STEGO_SCAN_SIZE bytes of every .bmp file are read,
+ * no payload is decoded and no output file is created
+ */
+
+/*
+ * Scan every .bmp file under dir on a pool of threads
+ * Prints one line per stego image : path, extension, payload size and depth
+ */
+Status do_scan(const char *dir, int threads);
+
+#endif
@@ -0,0 +1,121 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <openssl/evp.h>
+#include "scatter.h"
+
+/* Keeps the round keys apart from anything else made from the same phrase */
+#define SCATTER_DOMAIN "stego scatter v1"
+
+// 64 bit finalizer of splitmix64, every input bit reaches every output bit
+static inline unsigned long long scatter_mix(unsigned long long x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// One pass of the Feistel network over [0, 4^half_bits)
+static inline unsigned long long scatter_feistel(const Scatter *sc, unsigned long long x)
+{
+    unsigned long long mask = (1ULL << sc->half_bits) - 1, left = x >> sc->half_bits, right = x & mask, t;
+    int i;
+
+    for (i = 0; i < SCATTER_ROUNDS; i++)
+    {
+        t = left ^ (scatter_mix(right ^ sc->keys[i]) & mask);
+        left = right;
+        right = t;
+    }
+
+    return (left << sc->half_bits) | right;
+}
+
+Status scatter_init(Scatter *sc, const char *phrase, long base, long size, const BmpInfo *bmp)
+{
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len;
+    EVP_MD_CTX *ctx;
+    int i, ok;
+
+    memset(sc, 0, sizeof(*sc));
+    sc->base = base;
+    sc->bmp = bmp;
+    sc->cells = size > 0 ? size / SCATTER_CELL : 0;
+    if (sc->cells == 0)
+        return e_failure;
+
+    while ((1ULL << (2 * sc->half_bits)) < (unsigned long long)sc->cells)
+        sc->half_bits++;
+    if (sc->half_bits == 0)
+        sc->half_bits = 1;
+
+    // Round keys : SHA-256 of the domain and the phrase, 8 bytes each
+    ctx = EVP_MD_CTX_new();
+    ok = ctx != NULL && EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) == 1 &&
+         EVP_DigestUpdate(ctx, SCATTER_DOMAIN, strlen(SCATTER_DOMAIN)) == 1 &&
+         EVP_DigestUpdate(ctx, phrase, strlen(phrase)) == 1 &&
+         EVP_DigestFinal_ex(ctx, digest, &len) == 1 && len >= SCATTER_ROUNDS * 8;
+    EVP_MD_CTX_free(ctx);
+    if (!ok)
+        return e_failure;
+
+    for (i = 0; i < SCATTER_ROUNDS * 8; i++)
+        sc->keys[i / 8] = (sc->keys[i / 8] << 8) | digest[i];
+
+    return e_success;
+}
+
+long scatter_cell(const Scatter *sc, long cell)
+{
+    unsigned long long x = cell;
+
+    // Cycle walking : the domain is under 4 times the cell count, a few passes at most on average
+    do
+        x = scatter_feistel(sc, x);
+    while (x >= (unsigned long long)sc->cells);
+
+    return x;
+}
+
+long scatter_end(const Scatter *sc)
+{
+    return sc->base + sc->cells * SCATTER_CELL;
+}
+
+void scatter_gather(const Scatter *sc, const char *map, long pos, long n, char *buf)
+{
+    long cell = (pos - sc->base) / SCATTER_CELL, off = (pos - sc->base) % SCATTER_CELL, len;
+
+    for (; n > 0; cell++, off = 0, buf += len, n -= len)
+    {
+        len = SCATTER_CELL - off < n ? SCATTER_CELL - off : n;
+        if (sc->bmp != NULL)
+            bmp_gather(sc->bmp, map, sc->base + scatter_cell(sc, cell) * SCATTER_CELL + off, len, buf);
+        else
+            memcpy(buf, map + sc->base + scatter_cell(sc, cell) * SCATTER_CELL + off, len);
+    }
+}
+
+void scatter_put(const Scatter *sc, char *map, long pos, long n, const char *buf)
+{
+    long cell = (pos - sc->base) / SCATTER_CELL, off = (pos - sc->base) % SCATTER_CELL, len;
+
+    for (; n > 0; cell++, off = 0, buf += len, n -= len)
+    {
+        len = SCATTER_CELL - off < n ? SCATTER_CELL - off : n;
+        if (sc->bmp != NULL)
+            bmp_put(sc->bmp, map, sc->base + scatter_cell(sc, cell) * SCATTER_CELL + off, len, buf);
+        else
+            memcpy(map + sc->base + scatter_cell(sc, cell) * SCATTER_CELL + off, buf, len);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef SCATTER_H
+#define SCATTER_H
+
+#include "types.h"
+#include "bmp.h"
+
+/*
+ * Key-seeded scattered embedding (STEGO_FLAG_SCATTER, --scatter FILE)
+ * Everything after the secret file size field is spread over the rest of the
+ * pixel array instead of filling the cover bytes right after the header.
+ * That region is cut into cells of SCATTER_CELL cover bytes. Data is laid out
+ * exactly as if the cells were in order, at virtual stego offsets, and virtual
+ * cell i is stored in cell scatter_cell(i). The permutation is a balanced
+ * Feistel network over the cell index, keyed from the first line of FILE, with
+ * cycle walking down to the cell count : any offset maps to its cover bytes in
+ * constant time and nothing is tabulated, so stripes, --range and containers
+ * seek as before and memory doesn't grow with the cover.
+ * Cells are read in random order, so scattered images are always mapped (--mmap)
+ */
+
+/* Cover bytes per cell (override with -DSCATTER_CELL=...), 12 payload bytes at depth 1 */
+#ifndef SCATTER_CELL
+#define SCATTER_CELL 96
+#endif
+
+#define SCATTER_ROUNDS 4
+
+typedef struct
+{
+    /* First cover byte of the region, virtual offsets start here too */
+    long base;
+
+    /* Whole cells in the region */
+    long cells;
+
+    /* Feistel half width in bits, the network permutes 2 * half_bits bit indexes */
+    int half_bits;
+
+    unsigned long long keys[SCATTER_ROUNDS];
+
+    /* Colour bytes the cells are cut from when offsets are carrier offsets (bmp.h), NULL for file offsets */
+    const BmpInfo *bmp;
+} Scatter;
+
+/* Key the permutation with phrase over the size cover bytes from base, leftover bytes of a partial cell stay unused */
+Status scatter_init(Scatter *sc, const char *phrase, long base, long size, const BmpInfo *bmp);
+
+/* Cell holding virtual cell index cell */
+long scatter_cell(const Scatter *sc, long cell);
+
+/* End of the virtual offsets, base plus every whole cell */
+long scatter_end(const Scatter *sc);
+
+/* Copy n cover bytes at virtual offset pos out of map into buf */
+void scatter_gather(const Scatter *sc, const char *map, long pos, long n, char *buf);
+
+/* Copy n bytes of buf back to virtual offset pos of map */
+void scatter_put(const Scatter *sc, char *map, long pos, long n, const char *buf);
+
+#endif
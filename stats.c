@@ -0,0 +1,181 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "stats.h"
+#include "common.h"
+
+/* /proc/self/io counters used by a stage */
+typedef struct
+{
+    long rchar;
+    long wchar;
+    long calls;
+} IoCounters;
+
+/* Run being recorded and where its current stage started */
+static StegoStats *stats_current;
+static double stage_start;
+static IoCounters stage_io;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Read the I/O counters of the process, less what earlier calls of this function added to them
+// e_failure if /proc isn't there
+static Status read_io(IoCounters *io)
+{
+    static IoCounters self;
+    char buf[512], *line;
+    ssize_t n;
+    int fd = open("/proc/self/io", O_RDONLY);
+
+    memset(io, 0, sizeof(*io));
+    if (fd < 0)
+        return e_failure;
+
+    // One read() : the text shows the counters from before it, its own cost is exactly n bytes and 1 call
+    n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0)
+        return e_failure;
+    buf[n] = '\0';
+
+    for (line = strtok(buf, "\n"); line != NULL; line = strtok(NULL, "\n"))
+    {
+        long value;
+        char key[16];
+
+        if (sscanf(line, "%15s %ld", key, &value) != 2)
+            continue;
+        if (strcmp(key, "rchar:") == 0)
+            io->rchar = value - self.rchar;
+        else if (strcmp(key, "wchar:") == 0)
+            io->wchar = value;
+        else if (strcmp(key, "syscr:") == 0 || strcmp(key, "syscw:") == 0)
+            io->calls += value;
+    }
+    io->calls -= self.calls;
+
+    self.rchar += n;
+    self.calls++;
+    return e_success;
+}
+
+// STAGE_DONE() hook : closes the current stage and starts the next one
+static void stats_stage_done(const char *stage)
+{
+    StageStats *st;
+    IoCounters io;
+    double now = now_seconds();
+    int have_io = read_io(&io) == e_success;
+
+    if (stats_current->nstages < STATS_MAX_STAGES)
+    {
+        st = &stats_current->stages[stats_current->nstages++];
+        snprintf(st->name, sizeof(st->name), "%s", stage);
+        st->seconds = now - stage_start;
+        st->bytes_read = have_io ? io.rchar - stage_io.rchar : -1;
+        st->bytes_written = have_io ? io.wchar - stage_io.wchar : -1;
+        st->syscalls = have_io ? io.calls - stage_io.calls : -1;
+    }
+
+    stage_start = now_seconds();
+    read_io(&stage_io);
+}
+
+void stats_begin(StegoStats *stats, const char *operation)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->operation = operation;
+    stats_current = stats;
+    stego_stage_hook = stats_stage_done;
+    read_io(&stage_io);
+    stage_start = now_seconds();
+}
+
+void stats_end(StegoStats *stats)
+{
+    int i;
+
+    stats_stage_done("close_files");
+    stego_stage_hook = NULL;
+    stats_current = NULL;
+
+    for (i = 0; i < stats->nstages; i++)
+    {
+        const StageStats *st = &stats->stages[i];
+
+        stats->seconds += st->seconds;
+        stats->bytes_read = st->bytes_read < 0 ? -1 : stats->bytes_read + st->bytes_read;
+        stats->bytes_written = st->bytes_written < 0 ? -1 : stats->bytes_written + st->bytes_written;
+        stats->syscalls = st->syscalls < 0 ? -1 : stats->syscalls + st->syscalls;
+    }
+}
+
+void stats_print(const StegoStats *stats, FILE *fptr)
+{
+    int i;
+
+    fprintf(fptr, "INFO 📊 : %s stages\n", stats->operation);
+    fprintf(fptr, "%-30s %12s %14s %14s %10s %10s\n", "stage", "time (ms)", "read (B)", "written (B)", "syscalls", "MB/s");
+    for (i = 0; i < stats->nstages; i++)
+    {
+        const StageStats *st = &stats->stages[i];
+        long bytes = st->bytes_read > st->bytes_written ? st->bytes_read : st->bytes_written;
+
+        fprintf(fptr, "%-30s %12.3f %14ld %14ld %10ld %10.1f\n", st->name, st->seconds * 1e3,
+                st->bytes_read, st->bytes_written, st->syscalls,
+                st->seconds > 0 && bytes > 0 ? bytes / 1e6 / st->seconds : 0.0);
+    }
+    fprintf(fptr, "%-30s %12.3f %14ld %14ld %10ld\n\n", "total", stats->seconds * 1e3,
+            stats->bytes_read, stats->bytes_written, stats->syscalls);
+}
+
+void stats_print_json(const StegoStats *stats, FILE *fptr)
+{
+    int i;
+
+    fprintf(fptr, "{\"operation\": \"%s\", \"seconds\": %.6f, \"bytes_read\": %ld, \"bytes_written\": %ld, \"syscalls\": %ld, \"stages\": [",
+            stats->operation, stats->seconds, stats->bytes_read, stats->bytes_written, stats->syscalls);
+    for (i = 0; i < stats->nstages; i++)
+    {
+        const StageStats *st = &stats->stages[i];
+
+        fprintf(fptr, "%s{\"name\": \"%s\", \"seconds\": %.6f, \"bytes_read\": %ld, \"bytes_written\": %ld, \"syscalls\": %ld}",
+                i ? ", " : "", st->name, st->seconds, st->bytes_read, st->bytes_written, st->syscalls);
+    }
+    fprintf(fptr, "]}");
+}
+
+Status stats_write_json(const StegoStats *stats, const char *fname)
+{
+    // "-" is the message stream, which is stderr when stdout carries data
+    FILE *fptr = is_stdio_fname(fname) ? stdout : fopen(fname, "w");
+
+    if (fptr == NULL)
+    {
+        perror("fopen ");
+        printf("ERROR ❌ : Unable to write stats to %s\n", fname);
+        return e_failure;
+    }
+
+    stats_print_json(stats, fptr);
+    fprintf(fptr, "\n");
+    if (fptr == stdout)
+        return fflush(stdout) == 0 ? e_success : e_failure;
+    return fclose(fptr) == 0 ? e_success : e_failure;
+}
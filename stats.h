@@ -0,0 +1,56 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include "types.h"
+
+/*
+ * Stage statistics for do_encoding() / do_decoding() (--stats, --stats-json)
+ * Hooks into STAGE_DONE() and reads /proc/self/io at every stage boundary :
+ * wall time, bytes read and written through read() / write() style calls
+ * and the number of those calls. Data that moves through mmap (--mmap)
+ * shows up as time only. Not thread safe, one measured run per process at a time
+ */
+
+#define STATS_MAX_STAGES 16
+
+typedef struct
+{
+    char name[32];
+    double seconds;
+    long bytes_read;
+    long bytes_written;
+    long syscalls;
+} StageStats;
+
+typedef struct
+{
+    /* "encode" / "decode" */
+    const char *operation;
+
+    int nstages;
+    StageStats stages[STATS_MAX_STAGES];
+
+    /* Totals over all stages, -1 when /proc/self/io isn't readable */
+    double seconds;
+    long bytes_read;
+    long bytes_written;
+    long syscalls;
+} StegoStats;
+
+/* Start recording stages into stats */
+void stats_begin(StegoStats *stats, const char *operation);
+
+/* Stop recording, everything since the last stage becomes the close_files stage */
+void stats_end(StegoStats *stats);
+
+/* Print stats as a table */
+void stats_print(const StegoStats *stats, FILE *fptr);
+
+/* Print stats as one JSON object */
+void stats_print_json(const StegoStats *stats, FILE *fptr);
+
+/* Write stats as JSON to fname, e_failure if it can't be written */
+Status stats_write_json(const StegoStats *stats, const char *fname);
+
+#endif
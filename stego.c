@@ -0,0 +1,727 @@
+/*
+Documentation
+Name        :T Simhadri
+Date        :30/07/2025
+Description :Steganography Project
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <zlib.h>
+#include "stego.h"
+#include "lsb.h"
+#include "bmp.h"
+#include "crc32c.h"
+
+/* Bytes inflated at a time when a compressed payload is only measured */
+#define STEGO_SINK_SIZE (64 * 1024)
+
+/* Payload bytes extracted and checksummed together, a multiple of LSB_ALIGN */
+#define STEGO_CRC_CHUNK (LSB_ALIGN * 4096)
+
+/* Colour bytes gathered at a time on images with row padding or alpha, and the payload bytes they hold at depth 1 */
+#define STEGO_GATHER_SIZE 4096
+#define STEGO_GATHER_CHUNK (STEGO_GATHER_SIZE / 8 / LSB_ALIGN * LSB_ALIGN)
+
+/* Position in a cover / stego image held in memory, a carrier offset (bmp.h) when carriers is set */
+typedef struct
+{
+    const char *image;
+    char *out;
+    size_t image_size;
+    size_t size;
+    size_t pos;
+    BmpInfo bmp;
+    int carriers;
+} StegoCursor;
+
+// Go back to the first pixel byte, reading every byte of the pixel array like images before version 3
+static void stego_cursor_contiguous(StegoCursor *cur)
+{
+    cur->carriers = 0;
+    cur->pos = cur->bmp.pixel_offset;
+    cur->size = cur->image_size;
+    if ((size_t)cur->bmp.pixel_span < cur->image_size - cur->bmp.pixel_offset)
+        cur->size = cur->bmp.pixel_offset + cur->bmp.pixel_span;
+}
+
+// Point the cursor at the colour bytes of a BMP, limited to the buffer
+static Status stego_cursor_init(StegoCtx *ctx, StegoCursor *cur, const char *image, char *out, size_t image_size)
+{
+    if (bmp_parse_header(image, image_size, &cur->bmp) == e_failure)
+    {
+        ctx->error = cur->bmp.error;
+        return e_failure;
+    }
+
+    if (cur->bmp.pixel_offset > image_size)
+    {
+        ctx->error = "BMP image is truncated";
+        return e_failure;
+    }
+
+    cur->image = image;
+    cur->out = out;
+    cur->image_size = image_size;
+    stego_cursor_contiguous(cur);
+
+    // Row padding and alpha are left out, carrier offsets only count the colour bytes
+    if (bmp_has_gaps(&cur->bmp))
+    {
+        cur->carriers = 1;
+        cur->size = bmp_carrier_end(&cur->bmp, image_size);
+    }
+
+    return e_success;
+}
+
+// Embed n bytes depth bits per cover byte at the cursor
+static Status stego_put(StegoCtx *ctx, StegoCursor *cur, const char *data, size_t n, int depth)
+{
+    char cover[STEGO_GATHER_SIZE];
+    size_t chunk;
+
+    if (n > LSB_PAYLOAD_SIZE(cur->size - cur->pos, depth))
+    {
+        ctx->error = "cover image is too small for the payload";
+        return e_failure;
+    }
+
+    if (!cur->carriers)
+    {
+        lsb_embed(data, n, cur->out + cur->pos, depth);
+        cur->pos += LSB_COVER_SIZE(n, depth);
+        return e_success;
+    }
+
+    // Whole LSB_ALIGN units per chunk, every chunk starts on a whole colour byte
+    for (; n > 0; data += chunk, n -= chunk, cur->pos += LSB_COVER_SIZE(chunk, depth))
+    {
+        chunk = n < STEGO_GATHER_CHUNK ? n : STEGO_GATHER_CHUNK;
+        bmp_gather(&cur->bmp, cur->out, cur->pos, LSB_COVER_SIZE(chunk, depth), cover);
+        lsb_embed(data, chunk, cover, depth);
+        bmp_put(&cur->bmp, cur->out, cur->pos, LSB_COVER_SIZE(chunk, depth), cover);
+    }
+    return e_success;
+}
+
+// Extract n bytes depth bits per image byte at the cursor, data NULL just skips them
+static Status stego_get(StegoCtx *ctx, StegoCursor *cur, char *data, size_t n, int depth)
+{
+    char cover[STEGO_GATHER_SIZE];
+    size_t chunk;
+
+    // n comes from the image, check it before it gets multiplied
+    if (n > LSB_PAYLOAD_SIZE(cur->size - cur->pos, depth))
+    {
+        ctx->error = "stego image is truncated";
+        return e_failure;
+    }
+
+    if (data == NULL || !cur->carriers)
+    {
+        if (data != NULL)
+            lsb_extract(data, n, cur->image + cur->pos, depth);
+        cur->pos += LSB_COVER_SIZE(n, depth);
+        return e_success;
+    }
+
+    for (; n > 0; data += chunk, n -= chunk, cur->pos += LSB_COVER_SIZE(chunk, depth))
+    {
+        chunk = n < STEGO_GATHER_CHUNK ? n : STEGO_GATHER_CHUNK;
+        bmp_gather(&cur->bmp, cur->image, cur->pos, LSB_COVER_SIZE(chunk, depth), cover);
+        lsb_extract(data, chunk, cover, depth);
+    }
+    return e_success;
+}
+
+// Embed a 32 bit big endian field
+static Status stego_put_int(StegoCtx *ctx, StegoCursor *cur, uint value, int depth)
+{
+    char buffer[4];
+
+    buffer[0] = (value >> 24) & 0xFF;
+    buffer[1] = (value >> 16) & 0xFF;
+    buffer[2] = (value >> 8) & 0xFF;
+    buffer[3] = value & 0xFF;
+
+    return stego_put(ctx, cur, buffer, 4, depth);
+}
+
+// Extract a 32 bit big endian field, the first skip bytes are already 0
+static Status stego_get_int(StegoCtx *ctx, StegoCursor *cur, uint *value, int skip, int depth)
+{
+    unsigned char buffer[4] = {0};
+
+    if (stego_get(ctx, cur, (char *)buffer + skip, 4 - skip, depth) == e_failure)
+        return e_failure;
+
+    *value = ((uint)buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
+    return e_success;
+}
+
+// Embed the secret file size field, STEGO_SIZE_BYTES of STEGO_VERSION big endian bytes
+static Status stego_put_size(StegoCtx *ctx, StegoCursor *cur, unsigned long long value, int depth)
+{
+    char buffer[STEGO_MAX_SIZE_BYTES];
+    int i, n = STEGO_SIZE_BYTES(STEGO_VERSION);
+
+    for (i = 0; i < n; i++)
+        buffer[i] = (value >> (8 * (n - 1 - i))) & 0xFF;
+
+    return stego_put(ctx, cur, buffer, n, depth);
+}
+
+// Extract the secret file size field of a header version
+static Status stego_get_size(StegoCtx *ctx, StegoCursor *cur, unsigned long long *value, int version, int depth)
+{
+    unsigned char buffer[STEGO_MAX_SIZE_BYTES];
+    int i, n = STEGO_SIZE_BYTES(version);
+
+    if (stego_get(ctx, cur, (char *)buffer, n, depth) == e_failure)
+        return e_failure;
+
+    *value = 0;
+    for (i = 0; i < n; i++)
+        *value = (*value << 8) | buffer[i];
+    return e_success;
+}
+
+// Cover bytes used by everything except the payload, checksum trailer included
+static size_t stego_overhead(const StegoCtx *ctx)
+{
+    return (strlen(MAGIC_STRING) + STEGO_HEADER_SIZE) * 8
+           + LSB_COVER_SIZE(4, ctx->depth) + LSB_COVER_SIZE(strlen(ctx->extn), ctx->depth)
+           + LSB_COVER_SIZE(STEGO_SIZE_BYTES(STEGO_VERSION), ctx->depth) + LSB_COVER_SIZE(STEGO_CRC_SIZE, ctx->depth);
+}
+
+// Initialise a context with depth 1 and no extension
+Status stego_ctx_init(StegoCtx *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->depth = 1;
+    return e_success;
+}
+
+// Release what the context holds
+void stego_ctx_free(StegoCtx *ctx)
+{
+    free(ctx->scratch);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+// Get at least size bytes of scratch, reusing the buffer of earlier calls
+static char *stego_scratch(StegoCtx *ctx, size_t size)
+{
+    char *scratch;
+
+    if (size <= ctx->scratch_size)
+        return ctx->scratch;
+
+    scratch = realloc(ctx->scratch, size);
+    if (scratch == NULL)
+    {
+        ctx->error = "out of memory";
+        return NULL;
+    }
+
+    ctx->scratch = scratch;
+    ctx->scratch_size = size;
+    return scratch;
+}
+
+// Compress the payload in stego_encode()
+Status stego_ctx_set_compress(StegoCtx *ctx, int compress)
+{
+    ctx->compress = compress != 0;
+    return e_success;
+}
+
+// Set the LSB depth used by stego_encode()
+Status stego_ctx_set_depth(StegoCtx *ctx, int depth)
+{
+    if (depth < LSB_MIN_DEPTH || depth > LSB_MAX_DEPTH)
+    {
+        ctx->error = "LSB depth must be 1 to 4";
+        return e_failure;
+    }
+
+    ctx->depth = depth;
+    return e_success;
+}
+
+// Set the extension stored by stego_encode()
+Status stego_ctx_set_extn(StegoCtx *ctx, const char *extn)
+{
+    if (strlen(extn) > STEGO_MAX_EXTN)
+    {
+        ctx->error = "extension is too long";
+        return e_failure;
+    }
+
+    strcpy(ctx->extn, extn);
+    return e_success;
+}
+
+// Largest payload the cover can hold
+size_t stego_capacity(StegoCtx *ctx, const char *cover, size_t cover_size)
+{
+    StegoCursor cur;
+    size_t limit, overhead = stego_overhead(ctx);
+
+    if (stego_cursor_init(ctx, &cur, cover, NULL, cover_size) == e_failure)
+        return 0;
+
+    limit = cur.size - cur.pos;
+    if (limit <= overhead)
+        return 0;
+
+    // A compressed payload is one frame plus the closing 0 length
+    if (ctx->compress)
+    {
+        overhead += 2 * LSB_COVER_SIZE(4, ctx->depth);
+        if (limit <= overhead)
+            return 0;
+    }
+
+    // size payload bytes need ceil(size * 8 / depth) cover bytes
+    return (limit - overhead) * ctx->depth / 8;
+}
+
+// Embed payload into a copy of cover, same layout as do_encoding()
+Status stego_encode(StegoCtx *ctx, const char *cover, size_t cover_size,
+                    const char *payload, size_t payload_size, char *out)
+{
+    StegoCursor cur;
+    char header[STEGO_HEADER_SIZE];
+    uLongf packed_size;
+    const char *data = payload;
+    size_t data_size = payload_size;
+
+    ctx->error = NULL;
+
+    if (ctx->compress)
+    {
+        // The whole payload goes into the scratch buffer as one zlib stream
+        packed_size = compressBound(payload_size);
+        if (stego_scratch(ctx, packed_size) == NULL)
+            return e_failure;
+        if (compress2((Bytef *)ctx->scratch, &packed_size, (const Bytef *)payload, payload_size, STEGO_ZLIB_LEVEL) != Z_OK)
+        {
+            ctx->error = "compression failed";
+            return e_failure;
+        }
+        data = ctx->scratch;
+        data_size = packed_size;
+    }
+
+    if (stego_cursor_init(ctx, &cur, cover, out, cover_size) == e_failure)
+        return e_failure;
+
+    if (cur.size - cur.pos < stego_overhead(ctx) ||
+        data_size > stego_capacity(ctx, cover, cover_size))
+    {
+        ctx->error = "cover image is too small for the payload";
+        return e_failure;
+    }
+
+    // Header and untouched pixels come straight from the cover
+    if (out != cover)
+        memcpy(out, cover, cover_size);
+    cur.image = out;
+
+    header[0] = STEGO_VERSION;
+    header[1] = ctx->depth;
+    header[2] = STEGO_FLAG_CRC | (ctx->compress ? STEGO_FLAG_FRAMED | STEGO_FLAG_DEFLATE : 0);
+
+    if (stego_put(ctx, &cur, MAGIC_STRING, strlen(MAGIC_STRING), 1) == e_failure ||
+        stego_put(ctx, &cur, header, STEGO_HEADER_SIZE, 1) == e_failure ||
+        stego_put_int(ctx, &cur, strlen(ctx->extn), ctx->depth) == e_failure ||
+        stego_put(ctx, &cur, ctx->extn, strlen(ctx->extn), ctx->depth) == e_failure)
+        return e_failure;
+
+    if (!ctx->compress)
+    {
+        if (stego_put_size(ctx, &cur, payload_size, ctx->depth) == e_failure ||
+            stego_put(ctx, &cur, payload, payload_size, ctx->depth) == e_failure)
+            return e_failure;
+    }
+    else
+    {
+        // Framed : size 0, one frame with the zlib stream, then the 0 length
+        if (stego_put_size(ctx, &cur, 0, ctx->depth) == e_failure ||
+            stego_put_int(ctx, &cur, data_size, ctx->depth) == e_failure ||
+            stego_put(ctx, &cur, data, data_size, ctx->depth) == e_failure ||
+            stego_put_int(ctx, &cur, 0, ctx->depth) == e_failure)
+            return e_failure;
+    }
+
+    // Trailer with the checksum of the uncompressed payload
+    return stego_put_int(ctx, &cur, crc32c(0, payload, payload_size), ctx->depth);
+}
+
+// Whether the colour bytes start with the magic string of a version 3 image, the cursor stays where it is
+static int stego_in_carriers(StegoCtx *ctx, StegoCursor *cur)
+{
+    char magic[sizeof(MAGIC_STRING)];
+    unsigned char version;
+    size_t pos = cur->pos;
+    int found = 0;
+
+    if (stego_get(ctx, cur, magic, strlen(MAGIC_STRING), 1) == e_success &&
+        memcmp(magic, MAGIC_STRING, strlen(MAGIC_STRING)) == 0 &&
+        stego_get(ctx, cur, (char *)&version, 1, 1) == e_success)
+        found = version > STEGO_VERSION_CONTIGUOUS;
+
+    cur->pos = pos;
+    ctx->error = NULL;
+    return found;
+}
+
+// Read magic string, stego header, extension and size, leaving the cursor at the data
+static Status stego_read_headers(StegoCtx *ctx, StegoCursor *cur)
+{
+    char magic[sizeof(MAGIC_STRING)];
+    unsigned char header[STEGO_HEADER_SIZE];
+    uint extn_size;
+    unsigned long long size;
+    int legacy = 0, version = 0;
+
+    ctx->error = NULL;
+    ctx->flags = 0;
+    ctx->depth = 1;
+
+    // Images from before version 3 used the row padding and alpha too
+    if (cur->carriers && !stego_in_carriers(ctx, cur))
+        stego_cursor_contiguous(cur);
+
+    if (stego_get(ctx, cur, magic, strlen(MAGIC_STRING), 1) == e_failure)
+        return e_failure;
+    if (memcmp(magic, MAGIC_STRING, strlen(MAGIC_STRING)) != 0)
+    {
+        ctx->error = "magic string not found";
+        return e_failure;
+    }
+
+    if (stego_get(ctx, cur, (char *)header, 1, 1) == e_failure)
+        return e_failure;
+
+    if (header[0] == 0)
+    {
+        // Image from before the stego header, that byte starts the extension size
+        legacy = 1;
+    }
+    else
+    {
+        // Version 1 only differs in the size of the file size field
+        version = header[0];
+        if (version > STEGO_VERSION)
+        {
+            ctx->error = "unsupported stego header version";
+            return e_failure;
+        }
+        if (version > STEGO_VERSION_CONTIGUOUS && !cur->carriers && bmp_has_gaps(&cur->bmp))
+        {
+            ctx->error = "invalid stego header";
+            return e_failure;
+        }
+
+        if (stego_get(ctx, cur, (char *)header + 1, STEGO_HEADER_SIZE - 1, 1) == e_failure)
+            return e_failure;
+
+        ctx->depth = header[1];
+        ctx->flags = header[2];
+        if (ctx->depth < LSB_MIN_DEPTH || ctx->depth > LSB_MAX_DEPTH || (ctx->flags & ~STEGO_KNOWN_FLAGS))
+        {
+            ctx->error = "invalid stego header";
+            return e_failure;
+        }
+
+        // The fields below sit in FEC blocks, only the flags are known
+        if (ctx->flags & STEGO_FLAG_FEC)
+        {
+            ctx->extn[0] = '\0';
+            ctx->payload_size = 0;
+            return e_success;
+        }
+    }
+
+    if (stego_get_int(ctx, cur, &extn_size, legacy, ctx->depth) == e_failure)
+        return e_failure;
+    if (extn_size > STEGO_MAX_EXTN)
+    {
+        ctx->error = "invalid extension size";
+        return e_failure;
+    }
+
+    if (stego_get(ctx, cur, ctx->extn, extn_size, ctx->depth) == e_failure ||
+        stego_get_size(ctx, cur, &size, version, ctx->depth) == e_failure)
+        return e_failure;
+    ctx->extn[extn_size] = '\0';
+
+    if (size > (size_t)-1)
+    {
+        ctx->error = "payload size doesn't fit in memory";
+        return e_failure;
+    }
+    ctx->payload_size = size;
+
+    return e_success;
+}
+
+// Inflate one extracted frame into out, or only count the bytes when out is NULL
+static Status stego_inflate_frame(StegoCtx *ctx, z_stream *zs, char *frame, uint size,
+                                  char *out, size_t out_size, int *ended)
+{
+    int ret;
+
+    zs->next_in = (Bytef *)frame;
+    zs->avail_in = size;
+    do
+    {
+        if (out != NULL)
+        {
+            zs->next_out = (Bytef *)out + ctx->payload_size;
+            zs->avail_out = out_size - ctx->payload_size;
+        }
+        else
+        {
+            // Measuring only : inflate into the scratch space after the frame
+            zs->next_out = (Bytef *)frame + size;
+            zs->avail_out = STEGO_SINK_SIZE;
+        }
+
+        ret = inflate(zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+        {
+            ctx->error = "compressed payload is corrupt";
+            return e_failure;
+        }
+        ctx->payload_size = zs->total_out;
+        if (ret == Z_STREAM_END)
+            *ended = 1;
+
+        if (out != NULL && zs->avail_out == 0 && zs->avail_in > 0)
+        {
+            ctx->error = "output buffer is too small";
+            return e_failure;
+        }
+    } while (out == NULL && zs->avail_out == 0);
+
+    return e_success;
+}
+
+// Walk the frames of a STEGO_FLAG_FRAMED payload, copying them to out when it isn't NULL
+// Compressed frames are inflated, measuring them when out is NULL
+static Status stego_walk_frames(StegoCtx *ctx, StegoCursor *cur, char *out, size_t out_size)
+{
+    uint frame;
+    z_stream zs;
+    int deflated = ctx->flags & STEGO_FLAG_DEFLATE, ended = 0;
+    Status status = e_success;
+    char *data;
+
+    ctx->payload_size = 0;
+    if (deflated)
+    {
+        memset(&zs, 0, sizeof(zs));
+        if (inflateInit(&zs) != Z_OK)
+        {
+            ctx->error = "can't start decompression";
+            return e_failure;
+        }
+    }
+
+    while (status == e_success)
+    {
+        if ((status = stego_get_int(ctx, cur, &frame, 0, ctx->depth)) == e_failure || frame == 0)
+            break;
+
+        if (!deflated)
+        {
+            if (out != NULL && frame > out_size - ctx->payload_size)
+            {
+                ctx->error = "output buffer is too small";
+                return e_failure;
+            }
+
+            status = stego_get(ctx, cur, out != NULL ? out + ctx->payload_size : NULL, frame, ctx->depth);
+            ctx->payload_size += frame;
+            continue;
+        }
+
+        data = stego_scratch(ctx, (size_t)frame + STEGO_SINK_SIZE);
+        if (data == NULL || stego_get(ctx, cur, data, frame, ctx->depth) == e_failure)
+            status = e_failure;
+        else
+            status = stego_inflate_frame(ctx, &zs, data, frame, out, out_size, &ended);
+    }
+
+    if (deflated)
+    {
+        inflateEnd(&zs);
+        if (status == e_success && !ended)
+        {
+            ctx->error = "compressed payload is truncated";
+            status = e_failure;
+        }
+    }
+
+    return status;
+}
+
+// Sealed (--passphrase), scattered (--scatter) and FEC (--fec) payloads need the setup of the command line tool
+static Status stego_check_sealed(StegoCtx *ctx)
+{
+    if (ctx->flags & STEGO_FLAG_ENCRYPTED)
+    {
+        ctx->error = "encrypted payloads aren't supported by libstego";
+        return e_failure;
+    }
+    if (ctx->flags & STEGO_FLAG_SCATTER)
+    {
+        ctx->error = "scattered payloads aren't supported by libstego";
+        return e_failure;
+    }
+    if (ctx->flags & STEGO_FLAG_FEC)
+    {
+        ctx->error = "FEC protected payloads aren't supported by libstego";
+        return e_failure;
+    }
+    return e_success;
+}
+
+// Read only the headers at the start of a stego image
+Status stego_decode_header(StegoCtx *ctx, const char *stego, size_t stego_size)
+{
+    StegoCursor cur;
+
+    if (stego_cursor_init(ctx, &cur, stego, NULL, stego_size) == e_failure)
+        return e_failure;
+
+    return stego_read_headers(ctx, &cur);
+}
+
+// Read the headers of a stego image
+Status stego_decode_info(StegoCtx *ctx, const char *stego, size_t stego_size)
+{
+    StegoCursor cur;
+    size_t room;
+
+    if (stego_cursor_init(ctx, &cur, stego, NULL, stego_size) == e_failure)
+        return e_failure;
+
+    if (stego_read_headers(ctx, &cur) == e_failure || stego_check_sealed(ctx) == e_failure)
+        return e_failure;
+
+    // Framed payloads have to be walked to find their size
+    if (ctx->flags & STEGO_FLAG_FRAMED)
+        return stego_walk_frames(ctx, &cur, NULL, 0);
+
+    room = LSB_PAYLOAD_SIZE(cur.size - cur.pos, ctx->depth);
+    if (ctx->payload_size > room || ((ctx->flags & STEGO_FLAG_CRC) && ctx->payload_size + STEGO_CRC_SIZE > room))
+    {
+        ctx->error = "stego image is truncated";
+        return e_failure;
+    }
+
+    return e_success;
+}
+
+// Extract the payload of a stego image into out, checking it against the checksum trailer
+Status stego_decode(StegoCtx *ctx, const char *stego, size_t stego_size,
+                    char *out, size_t out_size)
+{
+    StegoCursor cur;
+    size_t pos, chunk;
+    uint crc = 0, stored;
+
+    if (stego_cursor_init(ctx, &cur, stego, NULL, stego_size) == e_failure)
+        return e_failure;
+
+    if (stego_read_headers(ctx, &cur) == e_failure || stego_check_sealed(ctx) == e_failure)
+        return e_failure;
+
+    if (ctx->flags & STEGO_FLAG_FRAMED)
+    {
+        if (stego_walk_frames(ctx, &cur, out, out_size) == e_failure)
+            return e_failure;
+        if (ctx->flags & STEGO_FLAG_CRC)
+            crc = crc32c(0, out, ctx->payload_size);
+    }
+    else
+    {
+        if (ctx->payload_size > out_size)
+        {
+            ctx->error = "output buffer is too small";
+            return e_failure;
+        }
+
+        // Checksum each chunk right after it is extracted, while it is still in cache
+        for (pos = 0; pos < ctx->payload_size; pos += chunk)
+        {
+            chunk = ctx->payload_size - pos < STEGO_CRC_CHUNK ? ctx->payload_size - pos : STEGO_CRC_CHUNK;
+            if (stego_get(ctx, &cur, out + pos, chunk, ctx->depth) == e_failure)
+                return e_failure;
+            crc = crc32c(crc, out + pos, chunk);
+        }
+    }
+
+    if (!(ctx->flags & STEGO_FLAG_CRC))
+        return e_success;
+
+    if (stego_get_int(ctx, &cur, &stored, 0, ctx->depth) == e_failure)
+        return e_failure;
+    if (stored != crc)
+    {
+        ctx->error = "payload checksum doesn't match, the image is corrupt";
+        return e_failure;
+    }
+
+    return e_success;
+}
+
+Status stego_decode_range(StegoCtx *ctx, const char *stego, size_t stego_size,
+                          size_t offset, char *out, size_t size)
+{
+    StegoCursor cur;
+    char unit[LSB_ALIGN];
+    size_t aligned, skip, n;
+
+    if (stego_cursor_init(ctx, &cur, stego, NULL, stego_size) == e_failure)
+        return e_failure;
+
+    if (stego_read_headers(ctx, &cur) == e_failure || stego_check_sealed(ctx) == e_failure)
+        return e_failure;
+
+    if (ctx->flags & STEGO_FLAG_FRAMED)
+    {
+        ctx->error = "framed payloads have no fixed offsets";
+        return e_failure;
+    }
+
+    if (offset > ctx->payload_size || size > ctx->payload_size - offset)
+    {
+        ctx->error = "range is outside the payload";
+        return e_failure;
+    }
+
+    // Payload bytes at multiples of LSB_ALIGN start on a whole cover byte, skip straight to the one before offset
+    aligned = offset / LSB_ALIGN * LSB_ALIGN;
+    skip = offset - aligned;
+    if (stego_get(ctx, &cur, NULL, aligned, ctx->depth) == e_failure)
+        return e_failure;
+
+    if (skip > 0 && size > 0)
+    {
+        // Leading bytes of a partial unit go through a small buffer, the rest is aligned again
+        n = skip + size < LSB_ALIGN ? skip + size : LSB_ALIGN;
+        if (stego_get(ctx, &cur, unit, n, ctx->depth) == e_failure)
+            return e_failure;
+        memcpy(out, unit + skip, n - skip);
+        out += n - skip;
+        size -= n - skip;
+    }
+
+    return stego_get(ctx, &cur, out, size, ctx->depth);
+}
@@ -0,0 +1,113 @@
+#ifndef STEGO_H
+#define STEGO_H
+
+#include <stddef.h>
+#include "types.h"
+#include "common.h"
+
+/*
+ * libstego : in-process, memory to memory encoding and decoding
+ * Produces and reads the same image layout as the command line tool,
+ * without any FILE * or progress messages. A context holds the settings
+ * and the state reused between calls, keep one per thread
+ */
+
+/* Longest file extension stored in an image */
+#define STEGO_MAX_EXTN 4
+
+/* Colour bytes that hold everything up to the payload at any depth */
+#define STEGO_HEADER_COVER ((sizeof(MAGIC_STRING) - 1 + STEGO_HEADER_SIZE + 4 + STEGO_MAX_EXTN + STEGO_MAX_SIZE_BYTES) * 8)
+
+/* Pixel bytes those can spread over, row padding and alpha add at most one byte in four */
+#define STEGO_HEADER_SPAN (STEGO_HEADER_COVER / 3 * 4 + 4)
+
+/* Bytes read first when scanning, enough for the headers of most BMPs (V5 header and masks included) */
+#define STEGO_SCAN_SIZE 512
+
+typedef struct _StegoCtx
+{
+    /* LSBs per cover byte used when encoding, read from the image when decoding */
+    int depth;
+
+    /* Non zero compresses the payload with zlib when encoding */
+    int compress;
+
+    /* File extension stored with the payload ("" for none) */
+    char extn[STEGO_MAX_EXTN + 1];
+
+    /* STEGO_FLAG_* bits of the last decoded image */
+    int flags;
+
+    /* Payload size of the last decoded image */
+    size_t payload_size;
+
+    /* Static description of the last failure */
+    const char *error;
+
+    /* Scratch buffer for compressed data, grown on demand and kept between calls */
+    char *scratch;
+    size_t scratch_size;
+
+} StegoCtx;
+
+/* Initialise a context with depth 1 and no extension */
+Status stego_ctx_init(StegoCtx *ctx);
+
+/* Release what the context holds, it can be initialised again */
+void stego_ctx_free(StegoCtx *ctx);
+
+/* Set the LSB depth (1 to 4) used by stego_encode() */
+Status stego_ctx_set_depth(StegoCtx *ctx, int depth);
+
+/* Compress the payload with zlib in stego_encode() (0 / 1) */
+Status stego_ctx_set_compress(StegoCtx *ctx, int compress);
+
+/* Set the extension (up to STEGO_MAX_EXTN characters) stored by stego_encode() */
+Status stego_ctx_set_extn(StegoCtx *ctx, const char *extn);
+
+/*
+ * Largest payload a 24-bit or 32-bit BMP cover (see bmp.h) can hold with the context settings,
+ * 0 if it can't hold any. Only the colour bytes count, row padding and alpha are left out
+ * With compression this is the limit for incompressible data
+ */
+size_t stego_capacity(StegoCtx *ctx, const char *cover, size_t cover_size);
+
+/*
+ * Embed payload into a copy of cover
+ * out must hold cover_size bytes and may be the cover itself
+ */
+Status stego_encode(StegoCtx *ctx, const char *cover, size_t cover_size,
+                    const char *payload, size_t payload_size, char *out);
+
+/*
+ * Read only the headers at the start of a stego image, stego may hold just
+ * the bytes up to bfOffBits + STEGO_HEADER_SPAN. Fills ctx->depth, ctx->flags, ctx->extn and
+ * ctx->payload_size, which is 0 for framed payloads as their size isn't stored
+ * and for FEC payloads (STEGO_FLAG_FEC), where only the flags and depth are read
+ */
+Status stego_decode_header(StegoCtx *ctx, const char *stego, size_t stego_size);
+
+/*
+ * Read the headers of a stego image
+ * Fills ctx->depth, ctx->flags, ctx->extn and ctx->payload_size
+ */
+Status stego_decode_info(StegoCtx *ctx, const char *stego, size_t stego_size);
+
+/*
+ * Extract the payload of a stego image into out (out_size bytes)
+ * ctx is filled like stego_decode_info(), ctx->payload_size bytes are written
+ * Fails if the image has a checksum (STEGO_FLAG_CRC) and the payload doesn't match it
+ */
+Status stego_decode(StegoCtx *ctx, const char *stego, size_t stego_size,
+                    char *out, size_t out_size);
+
+/*
+ * Extract payload bytes [offset, offset + size) into out, without touching
+ * the pixels of the bytes before offset. ctx is filled like stego_decode_info()
+ * Fails for framed payloads and ranges past ctx->payload_size. The checksum
+ * covers the whole payload, so it isn't checked here
+ */
+Status stego_decode_range(StegoCtx *ctx, const char *stego, size_t stego_size,
+                          size_t offset, char *out, size_t size);
+
+#endif
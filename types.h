@@ -17,7 +17,18 @@ typedef enum
 {
     e_encode,
     e_decode,
+    e_batch,
+    e_scan,
     e_unsupported
 } OperationType;
 
+/* How the stego offsets of a mapped image reach its cover bytes */
+typedef enum
+{
+    e_remap_none,       /* file offsets */
+    e_remap_carriers,   /* colour bytes only, row padding and alpha left out (bmp.h) */
+    e_remap_scatter,    /* scattered cells (scatter.h) */
+    e_remap_fec         /* data parts of the FEC blocks (fec.h) */
+} Remap;
+
 #endif